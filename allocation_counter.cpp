@@ -0,0 +1,40 @@
+#include "allocation_counter.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+
+static thread_local size_t thread_allocations = 0;
+
+void count_allocation() {
+    ++thread_allocations;
+}
+
+size_t thread_allocation_count() {
+    return thread_allocations;
+}
+
+// 計數後轉交 OpenCV 的標準 allocator；釋放時 UMatData 記錄的是標準 allocator，因此不會經過這裡
+class CountingMatAllocator : public MatAllocator {
+public:
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                       AccessFlag flags, UMatUsageFlags usage_flags) const override {
+        if (!data) {
+            count_allocation();
+        }
+        return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+    }
+
+    bool allocate(UMatData* data, AccessFlag access_flags, UMatUsageFlags usage_flags) const override {
+        return Mat::getStdAllocator()->allocate(data, access_flags, usage_flags);
+    }
+
+    void deallocate(UMatData* data) const override {
+        Mat::getStdAllocator()->deallocate(data);
+    }
+};
+
+void install_allocation_counter() {
+    static CountingMatAllocator allocator;
+    Mat::setDefaultAllocator(&allocator);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+// 以執行緒為單位累計 heap 配置次數，用來確認穩定狀態下處理每張影像不需配置記憶體。
+// cv::Mat 的緩衝區由 install_allocation_counter() 安裝的 MatAllocator 計數；
+// operator new 則需由執行檔自行替換並呼叫 count_allocation() (見 findcontour_time_10000.cpp)
+void install_allocation_counter();
+void count_allocation();
+size_t thread_allocation_count();
@@ -0,0 +1,111 @@
+#include "background_model.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BACKGROUND_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+void running_median_step(const Mat& frame, Mat& background) {
+    CV_Assert(frame.type() == CV_8UC1 && background.type() == CV_8UC1 && frame.size() == background.size());
+
+    for (int y = 0; y < frame.rows; ++y) {
+        const uchar* src = frame.ptr<uchar>(y);
+        uchar* bg = background.ptr<uchar>(y);
+
+        int x = 0;
+#ifdef BACKGROUND_SSE2
+        // 飽和減法的結果只要非 0 就代表該方向較大，與 1 取 min 得到 0 / 1
+        const __m128i one = _mm_set1_epi8(1);
+        for (; x + 16 <= frame.cols; x += 16) {
+            __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bg + x));
+            __m128i up = _mm_min_epu8(_mm_subs_epu8(f, b), one);
+            __m128i down = _mm_min_epu8(_mm_subs_epu8(b, f), one);
+            b = _mm_sub_epi8(_mm_add_epi8(b, up), down);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(bg + x), b);
+        }
+#endif
+        for (; x < frame.cols; ++x) {
+            bg[x] = static_cast<uchar>(bg[x] + (src[x] > bg[x]) - (src[x] < bg[x]));
+        }
+    }
+}
+
+BackgroundModel::BackgroundModel(CellPipeline& pipeline, const Mat& background, const BackgroundConfig& config)
+    : pipeline_(pipeline), config_(config), ring_(config.queue_slots, background.size()) {
+    CV_Assert(background.type() == CV_8UC1);
+    if (config_.method == BackgroundUpdate::RunningAverage) {
+        background.convertTo(average_, CV_32F);
+    } else {
+        median_ = background.clone();
+    }
+}
+
+BackgroundModel::~BackgroundModel() {
+    stop();
+}
+
+void BackgroundModel::start() {
+    CV_Assert(!started_ && "BackgroundModel cannot be restarted");
+    started_ = true;
+    updater_ = thread(&BackgroundModel::run, this);
+}
+
+void BackgroundModel::stop() {
+    if (updater_.joinable()) {
+        ring_.close();
+        updater_.join();
+    }
+}
+
+bool BackgroundModel::offer(const Mat& frame) {
+    FrameSlot* slot = frame.size() == ring_.frame_size() ? ring_.try_acquire() : nullptr;
+    if (!slot) {
+        dropped_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    frame.copyTo(slot->image);
+    ring_.publish(slot);
+    return true;
+}
+
+void BackgroundModel::update(const Mat& frame) {
+    if (config_.method == BackgroundUpdate::RunningAverage) {
+        accumulateWeighted(frame, average_, config_.alpha);
+    } else {
+        running_median_step(frame, median_);
+    }
+    samples_.fetch_add(1, memory_order_relaxed);
+}
+
+Mat BackgroundModel::current() const {
+    if (config_.method == BackgroundUpdate::RunningAverage) {
+        average_.convertTo(output_, CV_8U);
+        return output_;
+    }
+    return median_;
+}
+
+void BackgroundModel::publish() {
+    // set_background 產生新的 Mat，之後 current() 覆寫 output_ 不影響已發佈的背景
+    pipeline_.set_background(current());
+    published_.fetch_add(1, memory_order_relaxed);
+}
+
+void BackgroundModel::run() {
+    int pending = 0;
+    while (FrameSlot* slot = ring_.pop_ready()) {
+        update(slot->image);
+        ring_.release(slot);
+        if (++pending >= config_.publish_every) {
+            publish();
+            pending = 0;
+        }
+    }
+    if (pending > 0) {
+        publish();
+    }
+}
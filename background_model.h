@@ -0,0 +1,70 @@
+#pragma once
+
+#include "cell_pipeline.h"
+#include "ring_buffer.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+enum class BackgroundUpdate {
+    RunningAverage, // 指數移動平均 bg = (1 - alpha) * bg + alpha * frame
+    RunningMedian   // 近似移動中位數：每張影像讓每個像素往該影像的值移動 1
+};
+
+struct BackgroundConfig {
+    BackgroundUpdate method = BackgroundUpdate::RunningAverage;
+    double alpha = 0.02;
+    int publish_every = 16;  // 每累積幾張空影像發佈一次新背景 (發佈時需要重新模糊)
+    size_t queue_slots = 8;  // 等待更新的影像槽數量，全部使用中時 offer() 丟棄該張
+};
+
+// 以判定為空的影像 (沒有細胞) 逐步更新背景。
+// 處理影像的執行緒以 offer() 把影像複製到預先配置的影像槽後立即返回，
+// 更新在獨立的執行緒進行，每 publish_every 張呼叫一次 CellPipeline::set_background()
+// 以 atomic 方式替換背景；正在處理中的影像繼續使用舊的背景
+class BackgroundModel {
+public:
+    // background 為未模糊的初始背景 (CV_8UC1)
+    BackgroundModel(CellPipeline& pipeline, const cv::Mat& background, const BackgroundConfig& config = BackgroundConfig());
+    ~BackgroundModel();
+
+    // 只能 start 一次
+    void start();
+    // 處理完佇列中剩餘的影像並發佈最後的背景
+    void stop();
+
+    // 可由任意執行緒呼叫，不會阻塞；大小不符或沒有空槽時回傳 false
+    bool offer(const cv::Mat& frame);
+
+    // 直接以一張影像更新 (不經過佇列、不發佈)，只能在 start() 之前或 stop() 之後呼叫
+    void update(const cv::Mat& frame);
+    // 目前的背景 (CV_8UC1)，使用限制同 update()
+    cv::Mat current() const;
+
+    size_t samples() const { return samples_.load(std::memory_order_relaxed); }
+    size_t published() const { return published_.load(std::memory_order_relaxed); }
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void publish();
+
+    CellPipeline& pipeline_;
+    BackgroundConfig config_;
+    FrameRing ring_;
+    std::thread updater_;
+    bool started_ = false;
+
+    cv::Mat average_; // RunningAverage: CV_32FC1
+    cv::Mat median_;  // RunningMedian: CV_8UC1
+    mutable cv::Mat output_;
+
+    std::atomic<size_t> samples_{0};
+    std::atomic<size_t> published_{0};
+    std::atomic<size_t> dropped_{0};
+};
+
+// 近似移動中位數的一步：每個像素 bg += sign(frame - bg)。
+// 長期下來 bg 停在使 frame 大於與小於它的機率相等的值，即中位數
+void running_median_step(const cv::Mat& frame, cv::Mat& background);
@@ -0,0 +1,93 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "frame_workspace.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// 比較逐張 process 與 process_batch 在不同 batch 大小下每張影像的處理時間。
+// 資料夾內的影像依序排成 total_frames 張上下相接的 stack (不足時重複)，確認每種 batch 大小的結果與逐張處理相同
+int main(int argc, char** argv) {
+    string directory = argc > 1 ? argv[1] : "Test_images/Slight under focus";
+    int total_frames = argc > 2 ? atoi(argv[2]) : 1024;
+    const int repetitions = 20;
+    const int batch_sizes[] = {1, 2, 4, 8, 16, 32, 64, 128};
+
+    PipelineConfig config;
+    config.crop = SLIGHT_UNDER_FOCUS_CROP;
+    CellPipeline pipeline(config);
+    if (!pipeline.load_background(directory + "/background.tiff")) {
+        cerr << "Error: Could not read background image" << endl;
+        return 1;
+    }
+
+    vector<string> paths = list_images(directory);
+    vector<Mat> images;
+    for (const string& path : paths) {
+        Mat image = imread(path, IMREAD_GRAYSCALE);
+        if (!image.empty() && (images.empty() || image.size() == images[0].size())) {
+            images.push_back(image);
+        }
+    }
+    if (images.empty() || total_frames <= 0) {
+        cerr << "No images found in " << directory << endl;
+        return 1;
+    }
+
+    // 與 frame stack 檔案相同的緊密排列
+    const Size frame_size = images[0].size();
+    Mat stack(frame_size.height * total_frames, frame_size.width, CV_8UC1);
+    for (int i = 0; i < total_frames; ++i) {
+        Mat frame = stack.rowRange(i * frame_size.height, (i + 1) * frame_size.height);
+        images[i % images.size()].copyTo(frame);
+    }
+
+    FrameWorkspace workspace;
+    vector<FrameResult> expected(total_frames);
+    double single_time = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < total_frames; ++i) {
+            pipeline.process(stack.rowRange(i * frame_size.height, (i + 1) * frame_size.height), workspace, expected[i]);
+        }
+        single_time += chrono::duration<double, micro>(chrono::high_resolution_clock::now() - start).count();
+    }
+    cout << total_frames << " frames, " << repetitions << " repetitions" << endl;
+    cout << "  process:        " << single_time / (repetitions * total_frames) << " microseconds per frame" << endl;
+
+    int mismatches = 0;
+    vector<FrameResult> batch;
+    for (int batch_size : batch_sizes) {
+        double batch_time = 0;
+        for (int r = 0; r < repetitions; ++r) {
+            auto start = chrono::high_resolution_clock::now();
+            for (int first = 0; first < total_frames; first += batch_size) {
+                int count = min(batch_size, total_frames - first);
+                pipeline.process_batch(stack.rowRange(first * frame_size.height, (first + count) * frame_size.height),
+                                       count, workspace, batch);
+                if (r == 0) {
+                    for (int i = 0; i < count; ++i) {
+                        const FrameResult& a = expected[first + i];
+                        const FrameResult& b = batch[i];
+                        if (a.processed != b.processed || a.white_pixel_count != b.white_pixel_count || a.contours != b.contours) {
+                            mismatches++;
+                        }
+                    }
+                }
+            }
+            batch_time += chrono::duration<double, micro>(chrono::high_resolution_clock::now() - start).count();
+        }
+        cout << "  batch of " << batch_size << ":" << string(batch_size < 10 ? 3 : batch_size < 100 ? 2 : 1, ' ')
+             << batch_time / (repetitions * total_frames) << " microseconds per frame" << endl;
+    }
+
+    cout << mismatches << " mismatched results" << endl;
+    return mismatches == 0 ? 0 : 1;
+}
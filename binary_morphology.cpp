@@ -0,0 +1,103 @@
+#include "binary_morphology.h"
+#include "stage_timer.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MORPH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+BitMask::BitMask(int width, int height, int frame_height) {
+    create(width, height, frame_height);
+}
+
+void BitMask::create(int width, int height, int frame_height) {
+    width_ = width;
+    height_ = height;
+    frame_height_ = frame_height > 0 ? frame_height : height;
+    words_ = (width + 63) / 64;
+    last_mask_ = width % 64 == 0 ? ~0ull : (1ull << (width % 64)) - 1;
+    bits_.assign(static_cast<size_t>(words_) * height, 0);
+    scratch_.assign(static_cast<size_t>(words_) * height, 0);
+}
+
+void BitMask::pack(const Mat& binary) {
+    CV_Assert(binary.type() == CV_8UC1);
+    if (binary.cols != width_ || binary.rows != height_) {
+        create(binary.cols, binary.rows);
+    }
+
+    for (int y = 0; y < height_; ++y) {
+        const uchar* src = binary.ptr<uchar>(y);
+        uint64_t* dst = row(y);
+        memset(dst, 0, words_ * sizeof(uint64_t));
+
+        int x = 0;
+#ifdef MORPH_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width_; x += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+            uint64_t bits = static_cast<uint16_t>(~_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+            dst[x >> 6] |= bits << (x & 63);
+        }
+#endif
+        for (; x < width_; ++x) {
+            if (src[x]) {
+                dst[x >> 6] |= 1ull << (x & 63);
+            }
+        }
+    }
+}
+
+void BitMask::unpack(Mat& binary) const {
+    binary.create(height_, width_, CV_8UC1);
+    for (int y = 0; y < height_; ++y) {
+        const uint64_t* src = row(y);
+        uchar* dst = binary.ptr<uchar>(y);
+        for (int x = 0; x < width_; ++x) {
+            dst[x] = (src[x >> 6] >> (x & 63)) & 1 ? 255 : 0;
+        }
+    }
+}
+
+// 一次 3x3 十字結構元素的運算 (bit_cross_row)，stack 中每張影像的第一列與最後一列沒有上、下鄰列
+template <bool Dilate>
+void BitMask::step() {
+    for (int y = 0, frame_y = 0; y < height_; ++y, ++frame_y) {
+        if (frame_y == frame_height_) {
+            frame_y = 0;
+        }
+        const uint64_t* up = frame_y > 0 ? row(y - 1) : nullptr;
+        const uint64_t* down = frame_y < frame_height_ - 1 && y < height_ - 1 ? row(y + 1) : nullptr;
+        bit_cross_row<Dilate>(row(y), up, down, scratch_.data() + static_cast<size_t>(y) * words_, words_, last_mask_);
+    }
+    bits_.swap(scratch_);
+}
+
+void BitMask::dilate(int iterations) {
+    STAGE_TIMER(Dilate);
+    for (int i = 0; i < iterations; ++i) {
+        step<true>();
+    }
+}
+
+void BitMask::erode(int iterations) {
+    STAGE_TIMER(Erode);
+    for (int i = 0; i < iterations; ++i) {
+        step<false>();
+    }
+}
+
+void BitMask::apply(const vector<MorphStep>& steps) {
+    for (const MorphStep& s : steps) {
+        if (s.op == MorphOp::Dilate) {
+            dilate(s.iterations);
+        } else {
+            erode(s.iterations);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "cell_pipeline.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+// 每像素 1 bit 的二值影像，每列以 64 像素為一個 word 存放，bit i 對應 x = 64 * k + i。
+// 以位移與 AND/OR 實作 3x3 MORPH_CROSS 的 dilate / erode，
+// 邊界處理與 OpenCV 預設 (BORDER_CONSTANT + morphologyDefaultBorderValue) 相同：
+// dilate 時影像外視為 0，erode 時影像外視為 255。
+// frame_height 小於 height 時為多張影像上下相接的 stack，每 frame_height 列各自處理，
+// 上下相鄰的影像之間視為影像外
+// 一列的 3x3 十字運算，BitMask 與 fixed_geometry.cpp 共用：
+// dilate: out = c | c<<1 | c>>1 | up | down，影像外為 0
+// erode:  out = c & c<<1 & c>>1 & up & down，影像外為 1
+// up / down 為 nullptr 表示該方向在影像外；words 與 last_mask 為編譯期常數時整列可完全展開
+template <bool Dilate>
+inline void bit_cross_row(const uint64_t* c, const uint64_t* up, const uint64_t* down, uint64_t* out,
+                          int words, uint64_t last_mask) {
+    const uint64_t outside = Dilate ? 0 : ~0ull;
+    const uint64_t pad = ~last_mask;
+    const int last = words - 1;
+
+    for (int k = 0; k < words; ++k) {
+        uint64_t cur = c[k];
+        uint64_t next = k < last ? c[k + 1] : outside;
+        if (!Dilate && k == last) {
+            cur |= pad; // 最後一個 word 的多餘位元當作影像外
+        }
+
+        uint64_t left = (cur << 1) | (k > 0 ? c[k - 1] >> 63 : (outside & 1));
+        uint64_t right = (cur >> 1) | (next << 63);
+        uint64_t u = up ? up[k] : outside;
+        uint64_t d = down ? down[k] : outside;
+
+        if (Dilate) {
+            out[k] = cur | left | right | u | d;
+        } else {
+            out[k] = cur & left & right & u & d;
+        }
+    }
+    out[last] &= last_mask;
+}
+
+class BitMask {
+public:
+    BitMask() = default;
+    BitMask(int width, int height, int frame_height = 0);
+
+    // frame_height 為 0 時等於 height
+    void create(int width, int height, int frame_height = 0);
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int frame_height() const { return frame_height_; }
+    int words_per_row() const { return words_; }
+
+    uint64_t* row(int y) { return bits_.data() + static_cast<size_t>(y) * words_; }
+    const uint64_t* row(int y) const { return bits_.data() + static_cast<size_t>(y) * words_; }
+
+    // 非 0 像素視為前景；binary 大小不同時以單張影像重新配置
+    void pack(const cv::Mat& binary);
+    // 輸出 0 / 255 的 CV_8UC1
+    void unpack(cv::Mat& binary) const;
+
+    void dilate(int iterations = 1);
+    void erode(int iterations = 1);
+    void apply(const std::vector<MorphStep>& steps);
+
+private:
+    template <bool Dilate>
+    void step();
+
+    int width_ = 0;
+    int height_ = 0;
+    int frame_height_ = 0;
+    int words_ = 0;
+    uint64_t last_mask_ = 0;
+    std::vector<uint64_t> bits_;
+    std::vector<uint64_t> scratch_;
+};
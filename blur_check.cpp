@@ -0,0 +1,104 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "fused_threshold.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 在 CPU 支援的每個指令集下檢查整數 5x5 Gaussian 與 GaussianBlur(5x5, sigma=0, BORDER_REFLECT_101 | BORDER_ISOLATED)
+// 是否逐位元相同，並比較耗時。除了整張影像，也檢查 SLIGHT_UNDER_FOCUS_CROP 的 view 與隨機內容的影像
+int main() {
+    vector<string> directories = {"Test_images/512x96crop", "Test_images/Cropped", "Test_images/In focus",
+                                  "Test_images/Slight under focus"};
+    const int repetitions = 100;
+
+    // 隨機內容的影像：寬高小於核心時 REFLECT_101 會反射多次；
+    // 寬度不是向量寬度倍數時會走 SIMD 迴圈之後的尾端與右邊界
+    vector<int> widths;
+    for (int width = 1; width <= 40; ++width) {
+        widths.push_back(width);
+    }
+    for (int width : {63, 65, 97, 127, 129, 515, 997}) {
+        widths.push_back(width);
+    }
+
+    // 逐一檢查 CPU 支援的每個指令集，最後恢復偵測到的指令集
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512};
+    SimdLevel detected = fused_simd_level();
+
+    int total_mismatch_images = 0, total_random_mismatches = 0;
+    for (SimdLevel level : levels) {
+        if (!simd_level_supported(level)) {
+            continue;
+        }
+        set_simd_level_for_testing(level);
+        cout << "SIMD level: " << simd_level_name(level) << endl;
+
+        for (const string& directory : directories) {
+            double opencv_time = 0, integer_time = 0;
+            int mismatch_images = 0, images = 0;
+            for (const string& path : list_images(directory)) {
+                Mat image = imread(path, IMREAD_GRAYSCALE);
+                if (image.empty()) {
+                    continue;
+                }
+
+                Mat expected, actual;
+                auto start = chrono::high_resolution_clock::now();
+                for (int i = 0; i < repetitions; ++i) {
+                    GaussianBlur(image, expected, Size(5, 5), 0, 0, BORDER_DEFAULT | BORDER_ISOLATED);
+                }
+                auto middle = chrono::high_resolution_clock::now();
+                for (int i = 0; i < repetitions; ++i) {
+                    gaussian_blur_5x5(image, actual);
+                }
+                auto end = chrono::high_resolution_clock::now();
+                opencv_time += chrono::duration<double, micro>(middle - start).count();
+                integer_time += chrono::duration<double, micro>(end - middle).count();
+
+                int diff = countNonZero(expected != actual);
+                if ((SLIGHT_UNDER_FOCUS_CROP & Rect(Point(0, 0), image.size())) == SLIGHT_UNDER_FOCUS_CROP) {
+                    Mat view = image(SLIGHT_UNDER_FOCUS_CROP);
+                    GaussianBlur(view, expected, Size(5, 5), 0, 0, BORDER_DEFAULT | BORDER_ISOLATED);
+                    gaussian_blur_5x5(view, actual);
+                    diff += countNonZero(expected != actual);
+                }
+                if (diff > 0) {
+                    cout << "Mismatch: " << path << " (" << diff << " pixels)" << endl;
+                    mismatch_images++;
+                }
+                images++;
+            }
+
+            int runs = max(1, images * repetitions);
+            cout << directory << ": " << images << " images, " << mismatch_images << " mismatched" << endl;
+            cout << "  OpenCV GaussianBlur: " << opencv_time / runs << " microseconds" << endl;
+            cout << "  Integer blur:        " << integer_time / runs << " microseconds" << endl;
+            total_mismatch_images += mismatch_images;
+        }
+
+        int random_mismatches = 0;
+        for (int height = 1; height <= 8; ++height) {
+            for (int width : widths) {
+                Mat image(height, width, CV_8UC1), expected, actual;
+                randu(image, 0, 256);
+                GaussianBlur(image, expected, Size(5, 5), 0, 0, BORDER_DEFAULT | BORDER_ISOLATED);
+                gaussian_blur_5x5(image, actual);
+                if (countNonZero(expected != actual) > 0) {
+                    cout << "Mismatch: " << width << "x" << height << " random image" << endl;
+                    random_mismatches++;
+                }
+            }
+        }
+        cout << "Random images: " << random_mismatches << " mismatched" << endl;
+        total_random_mismatches += random_mismatches;
+    }
+    set_simd_level_for_testing(detected);
+
+    return total_mismatch_images == 0 && total_random_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include "background_model.h"
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "frame_source.h"
+#include "frame_store.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 以模擬相機固定 fps 送出影像，量測持續吞吐量、丟棄率與佇列深度
+// 用法: camera_sim [fps] [線程數] [張數] [抖動微秒] [off|average|median]
+// 最後一個參數以空影像持續更新背景 (background_model.h)
+int main(int argc, char** argv) {
+    CameraConfig camera_config;
+    camera_config.fps = argc > 1 ? atof(argv[1]) : camera_config.fps;
+    int num_threads = argc > 2 ? atoi(argv[2]) : 0;
+    camera_config.frame_count = argc > 3 ? static_cast<size_t>(atoll(argv[3])) : camera_config.frame_count;
+    camera_config.jitter_us = argc > 4 ? atof(argv[4]) : camera_config.jitter_us;
+    string background_mode = argc > 5 ? argv[5] : "off";
+
+    string directory = "Test_images/Slight under focus";
+    PipelineConfig config;
+    config.crop = SLIGHT_UNDER_FOCUS_CROP;
+    CellPipeline pipeline(config);
+    FrameStore dataset;
+    if (!pipeline.load_background(directory + "/background.tiff") || !dataset.load_directory(directory)) {
+        cerr << "Error: Could not preload images in " << directory << endl;
+        return 1;
+    }
+
+    unique_ptr<BackgroundModel> background;
+    if (background_mode != "off") {
+        BackgroundConfig background_config;
+        background_config.method = background_mode == "median" ? BackgroundUpdate::RunningMedian : BackgroundUpdate::RunningAverage;
+        background.reset(new BackgroundModel(pipeline, pipeline.crop(imread(directory + "/background.tiff", IMREAD_GRAYSCALE)), background_config));
+        pipeline.set_background_model(background.get());
+        background->start();
+    }
+
+    SimulatedCamera camera(dataset, camera_config);
+    vector<FrameResult> results;
+    camera.start();
+    RunStats stats = run_source(pipeline, camera, results, 0, num_threads);
+    camera.stop();
+    if (background) {
+        background->stop();
+        pipeline.set_background_model(nullptr);
+    }
+    CameraStats camera_stats = camera.stats();
+
+    size_t processed = 0;
+    for (const FrameResult& result : results) {
+        if (result.processed) {
+            processed++;
+        }
+    }
+
+    cout << "Camera: " << camera_config.fps << " fps, jitter " << camera_config.jitter_us << " us, ring capacity "
+         << camera_config.ring_capacity << endl;
+    cout << "Produced: " << camera_stats.produced << ", dropped: " << camera_stats.dropped << " ("
+         << (camera_stats.produced ? 100.0 * camera_stats.dropped / camera_stats.produced : 0) << " %)" << endl;
+    cout << "Queue depth: mean " << camera_stats.mean_queue_depth << ", max " << camera_stats.max_queue_depth << endl;
+    cout << "Processed " << processed << " of " << results.size() << " received frames" << endl;
+    if (background) {
+        cout << "Background (" << background_mode << "): " << background->samples() << " empty frames, "
+             << background->published() << " updates published, " << background->dropped() << " dropped" << endl;
+    }
+    print_run_stats(stats);
+    stats.latency.print(cout);
+
+    return 0;
+}
@@ -0,0 +1,866 @@
+#define _USE_MATH_DEFINES
+#include "cell_pipeline.h"
+#include "background_model.h"
+#include "binary_morphology.h"
+#include "cell_tracker.h"
+#include "contour_tracer.h"
+#include "convex_hull.h"
+#include "fixed_geometry.h"
+#include "frame_workspace.h"
+#include "fused_threshold.h"
+#include "stage_timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace cv;
+using namespace std;
+
+static double circularity(double area, double perimeter, CircularityFormula formula) {
+    if (formula == CircularityFormula::SqrtIsoperimetric) {
+        return 2 * sqrt(M_PI * area) / perimeter;
+    }
+    return 4 * M_PI * area / (perimeter * perimeter);
+}
+
+ContourMetrics contour_metrics(const vector<Point>& cnt, double area_original, double perimeter_original, CircularityFormula formula,
+                               vector<Point>* hull_buffer) {
+    if (area_original <= 1e-6 || perimeter_original <= 1e-6) {
+        return ContourMetrics();
+    }
+
+    double circularity_original = circularity(area_original, perimeter_original, formula);
+
+    double area_hull, perimeter_hull;
+    {
+        STAGE_TIMER(Hull);
+        HullMetrics hull = convex_hull_metrics(cnt, hull_buffer);
+        area_hull = hull.area;
+        perimeter_hull = hull.perimeter;
+    }
+
+    if (area_hull <= 1e-6 || perimeter_hull <= 1e-6) {
+        return ContourMetrics();
+    }
+
+    double circularity_hull = circularity(area_hull, perimeter_hull, formula);
+
+    ContourMetrics results;
+    results.area_original = area_original;
+    results.area_hull = area_hull;
+    results.area_ratio = area_hull / area_original;
+    results.circularity_original = circularity_original;
+    results.circularity_hull = circularity_hull;
+    results.circularity_ratio = circularity_hull / circularity_original;
+
+    return results;
+}
+
+int largest_contour(const vector<vector<Point>>& contours, double* area) {
+    int largest = -1;
+    double largest_area = 0;
+    for (size_t i = 0; i < contours.size(); ++i) {
+        double a = contourArea(contours[i]);
+        if (largest < 0 || a > largest_area) {
+            largest = static_cast<int>(i);
+            largest_area = a;
+        }
+    }
+    if (area) {
+        *area = largest_area;
+    }
+    return largest;
+}
+
+ContourMetrics calculate_contour_metrics(const vector<vector<Point>>& contours, CircularityFormula formula, int* largest_index,
+                                         vector<Point>* hull_buffer) {
+    double area = 0;
+    int largest = largest_contour(contours, &area);
+    if (largest_index) {
+        *largest_index = largest;
+    }
+    if (largest < 0) {
+        return ContourMetrics();
+    }
+
+    const vector<Point>& cnt = contours[largest];
+    return contour_metrics(cnt, area, arcLength(cnt, true), formula, hull_buffer);
+}
+
+const char* skip_reason_name(SkipReason reason) {
+    switch (reason) {
+    case SkipReason::None: return "none";
+    case SkipReason::ReadError: return "read error";
+    case SkipReason::WhitePixelCount: return "white pixel count out of range";
+    case SkipReason::DeadlineSegment: return "deadline exceeded after segmentation";
+    case SkipReason::DeadlineMorphology: return "deadline exceeded during morphology";
+    case SkipReason::DeadlineContours: return "deadline exceeded during contours";
+    case SkipReason::Tracked: return "already measured in a better focused frame";
+    default: return "unknown";
+    }
+}
+
+bool is_deadline_skip(SkipReason reason) {
+    return reason == SkipReason::DeadlineSegment || reason == SkipReason::DeadlineMorphology ||
+           reason == SkipReason::DeadlineContours;
+}
+
+static inline bool past_deadline(uint64_t deadline_cycles) {
+    return deadline_cycles && read_cycles() > deadline_cycles;
+}
+
+CellPipeline::CellPipeline(const PipelineConfig& config)
+    : config_(config), kernel_(getStructuringElement(MORPH_CROSS, Size(3, 3))) {
+    // 校正只在這裡做一次，處理影像時只需讀 cycle counter
+    if (config_.time_limit_us > 0) {
+        budget_cycles_ = static_cast<uint64_t>(config_.time_limit_us * cycles_per_microsecond());
+    }
+}
+
+bool CellPipeline::load_background(const string& background_path) {
+    Mat background = imread(background_path, IMREAD_GRAYSCALE);
+    if (background.empty() || (background.size() != config_.crop.size() && crop(background).empty())) {
+        return false;
+    }
+    set_background(background);
+    return true;
+}
+
+// ROI 粗略偵測只縮小左上角可被 scale 整除的範圍，INTER_AREA 即為完整區塊的平均；
+// 右、下不足一格的邊緣不參與縮小，前景碰到最後一格時 find_roi 把 ROI 延伸到影像邊緣
+static Rect coarse_region(Size size, int scale) {
+    return Rect(0, 0, min(size.width, max(size.width / scale, 1) * scale), min(size.height, max(size.height / scale, 1) * scale));
+}
+
+static Size coarse_size(Size size, int scale) {
+    return Size(max(size.width / scale, 1), max(size.height / scale, 1));
+}
+
+Mat CellPipeline::crop(const Mat& frame) const {
+    if (config_.crop.empty()) {
+        return frame;
+    }
+    if ((config_.crop & Rect(Point(0, 0), frame.size())) != config_.crop) {
+        return Mat();
+    }
+    return frame(config_.crop);
+}
+
+void CellPipeline::set_background(const Mat& background) {
+    // BackgroundModel 發佈的背景已經是裁切後的大小
+    Mat cropped = background.size() == config_.crop.size() ? background : crop(background);
+    CV_Assert(!cropped.empty());
+
+    auto images = make_shared<Background>();
+    blur_image(cropped, images->blurred);
+    if (config_.use_roi) {
+        resize(images->blurred(coarse_region(cropped.size(), config_.roi_scale)), images->coarse,
+               coarse_size(cropped.size(), config_.roi_scale), 0, 0, INTER_AREA);
+    }
+    atomic_store(&background_, shared_ptr<const Background>(std::move(images)));
+}
+
+void CellPipeline::blur_image(const Mat& image, Mat& blurred) const {
+    if (config_.use_integer_blur && config_.blur_size == 5 && image.type() == CV_8UC1) {
+        gaussian_blur_5x5(image, blurred);
+        return;
+    }
+    GaussianBlur(image, blurred, Size(config_.blur_size, config_.blur_size), 0, 0, BORDER_DEFAULT | BORDER_ISOLATED);
+}
+
+Mat CellPipeline::blurred_background() const {
+    shared_ptr<const Background> background = atomic_load(&background_);
+    return background ? background->blurred : Mat();
+}
+
+void CellPipeline::segment(const Mat& image, Mat& binary, ForegroundStats* foreground) const {
+    FrameWorkspace workspace;
+    segment(image, binary, workspace, foreground);
+}
+
+void CellPipeline::segment(const Mat& image, Mat& binary, FrameWorkspace& workspace, ForegroundStats* foreground) const {
+    shared_ptr<const Background> background = atomic_load(&background_);
+    segment(image, background ? background->blurred : Mat(), binary, workspace, foreground);
+}
+
+void CellPipeline::segment(const Mat& image, const Mat& blurred_bg, Mat& binary, FrameWorkspace& workspace,
+                           ForegroundStats* foreground) const {
+    if (config_.use_fused_kernel && config_.blur_size == 5 && image.type() == CV_8UC1 && image.size() == blurred_bg.size()) {
+        STAGE_TIMER(FusedSegment);
+        fused_blur_subtract_threshold(image, blurred_bg, config_.threshold_value, binary, foreground);
+        return;
+    }
+
+    // image 為 view 時 blur_image 不讀取範圍外的像素，與融合核心的邊界處理相同
+    Mat blurred = workspace_region(workspace.blurred, image.size());
+    Mat bg_sub = workspace_region(workspace.bg_sub, image.size());
+    {
+        STAGE_TIMER(Blur);
+        blur_image(image, blurred);
+    }
+    {
+        STAGE_TIMER(Subtract);
+        subtract(blurred_bg, blurred, bg_sub);
+    }
+    {
+        STAGE_TIMER(Threshold);
+        threshold(bg_sub, binary, config_.threshold_value, 255, THRESH_BINARY);
+    }
+    if (foreground) {
+        STAGE_TIMER(WhiteCount);
+        foreground->count = countNonZero(binary);
+        foreground->bounds = foreground->count ? boundingRect(binary) : Rect();
+    }
+}
+
+bool CellPipeline::find_roi(const Mat& image, const Background& background, FrameWorkspace& workspace, Rect& roi) const {
+    STAGE_TIMER(Roi);
+    resize(image(coarse_region(image.size(), config_.roi_scale)), workspace.coarse, background.coarse.size(), 0, 0, INTER_AREA);
+    subtract(background.coarse, workspace.coarse, workspace.coarse_diff);
+    threshold(workspace.coarse_diff, workspace.coarse_diff, config_.roi_threshold, 255, THRESH_BINARY);
+    Rect found = boundingRect(workspace.coarse_diff);
+    if (found.empty()) {
+        return false;
+    }
+
+    const int scale = config_.roi_scale;
+    const int margin = config_.roi_margin;
+    roi = Rect(found.x * scale - margin, found.y * scale - margin,
+               found.width * scale + 2 * margin, found.height * scale + 2 * margin);
+    // 前景碰到最右或最下一格時延伸到影像邊緣，包含 coarse_region 之外的像素
+    if (found.x + found.width == workspace.coarse_diff.cols) {
+        roi.width = image.cols - roi.x;
+    }
+    if (found.y + found.height == workspace.coarse_diff.rows) {
+        roi.height = image.rows - roi.y;
+    }
+    roi &= Rect(Point(0, 0), image.size());
+    return true;
+}
+
+void CellPipeline::morphology(const Mat& binary, Mat& morphed) const {
+    FrameWorkspace workspace;
+    morphology(binary, morphed, workspace);
+}
+
+void CellPipeline::morphology(const Mat& binary, Mat& morphed, FrameWorkspace& workspace) const {
+    run_morphology(binary, morphed, workspace, 0);
+}
+
+bool CellPipeline::use_bit_engine() const {
+    // (1, 1) 即為 3x3 核心的中心
+    return config_.use_bit_morphology && (config_.morph_anchor == Point(-1, -1) || config_.morph_anchor == Point(1, 1));
+}
+
+bool CellPipeline::run_morphology(const Mat& binary, Mat& morphed, FrameWorkspace& workspace, uint64_t deadline_cycles) const {
+    if (use_bit_engine()) {
+        const FixedGeometryKernels* fixed = config_.use_fixed_geometry ? find_fixed_kernels(binary.size()) : nullptr;
+        if (fixed && binary.type() == CV_8UC1) {
+            Mat unpacked = workspace_region(workspace.morphed, binary.size());
+            if (!fixed->morphology(binary.ptr<uchar>(), binary.step, unpacked.ptr<uchar>(), unpacked.step,
+                                   config_.morphology.data(), config_.morphology.size(), deadline_cycles)) {
+                return false;
+            }
+            morphed = unpacked;
+            return true;
+        }
+
+        {
+            STAGE_TIMER(MorphPack);
+            workspace.bits.pack(binary);
+        }
+        for (const MorphStep& step : config_.morphology) {
+            if (step.op == MorphOp::Dilate) {
+                workspace.bits.dilate(step.iterations);
+            } else {
+                workspace.bits.erode(step.iterations);
+            }
+            if (past_deadline(deadline_cycles)) {
+                return false;
+            }
+        }
+        STAGE_TIMER(MorphUnpack);
+        Mat unpacked = workspace_region(workspace.morphed, binary.size());
+        workspace.bits.unpack(unpacked);
+        morphed = unpacked;
+        return true;
+    }
+
+    // 在 ping / pong 兩塊緩衝區之間交替，最後 morphed 指向最後一次的輸出
+    const Mat* src = &binary;
+    Mat buffers[2] = { workspace_region(workspace.morph_ping, binary.size()),
+                       workspace_region(workspace.morph_pong, binary.size()) };
+    for (size_t i = 0; i < config_.morphology.size(); ++i) {
+        const MorphStep& step = config_.morphology[i];
+        Mat& next = buffers[i & 1];
+        if (step.op == MorphOp::Dilate) {
+            STAGE_TIMER(Dilate);
+            dilate(*src, next, kernel_, config_.morph_anchor, step.iterations);
+        } else {
+            STAGE_TIMER(Erode);
+            erode(*src, next, kernel_, config_.morph_anchor, step.iterations);
+        }
+        src = &next;
+        if (past_deadline(deadline_cycles)) {
+            return false;
+        }
+    }
+    morphed = *src;
+    return true;
+}
+
+static double elapsed_us(const FrameState& state) {
+    return chrono::duration<double, micro>(chrono::high_resolution_clock::now() - state.start_time).count();
+}
+
+// 記錄是在哪個階段之後超時
+static void mark_late(FrameState& state, SkipReason reason) {
+    state.result.skip_reason = reason;
+    state.result.duration = elapsed_us(state);
+}
+
+static bool abort_if_late(FrameState& state, SkipReason reason) {
+    if (!past_deadline(state.deadline_cycles)) {
+        return false;
+    }
+    mark_late(state, reason);
+    return true;
+}
+
+// 重設除了輪廓以外的所有欄位，輪廓 vector 留給下一次寫入
+static void reset_result(FrameResult& out) {
+    out.processed = false;
+    out.skip_reason = SkipReason::None;
+    out.white_pixel_count = 0;
+    out.foreground_bounds = Rect();
+    out.largest_contour = -1;
+    out.metrics = ContourMetrics();
+    out.cells.clear();
+    out.track_id = -1;
+    out.roi = Rect();
+    out.duration = 0;
+    out.findcontour_duration = 0;
+    out.preprocess_duration = 0;
+    out.metrics_duration = 0;
+    out.total_duration = 0;
+}
+
+FrameState::FrameState() = default;
+FrameState::~FrameState() = default;
+FrameState::FrameState(FrameState&&) = default;
+FrameState& FrameState::operator=(FrameState&&) = default;
+
+void FrameState::reset() {
+    image.release();
+    mask.release();
+    roi = Rect();
+    reset_result(result);
+    result.contours.clear();
+    traced = false;
+    contour_area = 0;
+    contour_perimeter = 0;
+    deadline_cycles = 0;
+}
+
+FrameWorkspace& CellPipeline::workspace_for(FrameState& state) const {
+    if (state.workspace) {
+        return *state.workspace;
+    }
+    if (!state.owned_workspace) {
+        state.owned_workspace.reset(new FrameWorkspace());
+    }
+    return *state.owned_workspace;
+}
+
+bool CellPipeline::decode(const string& image_path, FrameState& state) const {
+    state.image = imread(image_path, IMREAD_GRAYSCALE);
+    if (state.image.empty()) {
+        state.result.skip_reason = SkipReason::ReadError;
+        return false;
+    }
+    return true;
+}
+
+bool CellPipeline::white_pixels_in_range(int count) const {
+    int max_white_pixels = config_.multi_cell ? config_.max_white_pixels * config_.max_cells : config_.max_white_pixels;
+    return count >= config_.min_white_pixels && count <= max_white_pixels;
+}
+
+bool CellPipeline::preprocess(FrameState& state) const {
+    return preprocess(state, nullptr, nullptr);
+}
+
+bool CellPipeline::preprocess(FrameState& state, CellTracker* tracker, TrackDecision* decision) const {
+    FrameResult& result = state.result;
+    state.start_time = chrono::high_resolution_clock::now();
+    if (budget_cycles_ && !state.deadline_cycles) {
+        state.deadline_cycles = read_cycles() + budget_cycles_;
+    }
+
+    // 之後各階段只看到裁切範圍
+    state.image = crop(state.image);
+    if (state.image.empty()) {
+        result.skip_reason = SkipReason::ReadError;
+        return false;
+    }
+
+    FrameWorkspace& workspace = workspace_for(state);
+
+    // 整張影像使用同一個背景，即使處理途中背景被替換
+    shared_ptr<const Background> background = atomic_load(&background_);
+    const Mat& blurred_bg = background ? background->blurred : Mat();
+
+    state.roi = Rect(Point(0, 0), state.image.size());
+    if (config_.use_roi && background && !background->coarse.empty() && state.image.size() == blurred_bg.size()) {
+        Rect roi;
+        if (find_roi(state.image, *background, workspace, roi)) {
+            state.roi = roi;
+        } else if (config_.filter_white_pixels && config_.min_white_pixels > 0) {
+            // 沒有前景：白色像素視為 0
+            result.roi = Rect();
+            result.white_pixel_count = 0;
+            if (background_model_) {
+                background_model_->offer(state.image);
+            }
+            result.skip_reason = SkipReason::WhitePixelCount;
+            result.preprocess_duration = elapsed_us(state);
+            return false;
+        }
+    }
+    result.roi = state.roi;
+
+    // 需要白色像素數或外接矩形時由 segment 一併算出，不另外掃描 binary
+    bool count_foreground = config_.filter_white_pixels || background_model_ || tracker;
+    ForegroundStats foreground;
+    Mat binary = workspace_region(workspace.binary, state.roi.size());
+    if (state.roi.size() == state.image.size()) {
+        segment(state.image, blurred_bg, binary, workspace, count_foreground ? &foreground : nullptr);
+    } else {
+        segment(state.image(state.roi), blurred_bg(state.roi), binary, workspace, count_foreground ? &foreground : nullptr);
+    }
+
+    if (count_foreground) {
+        result.white_pixel_count = foreground.count;
+        result.foreground_bounds = foreground.bounds;
+        if (!foreground.bounds.empty()) {
+            result.foreground_bounds += state.roi.tl();
+        }
+        // 沒有細胞的影像用來更新背景
+        if (background_model_ && result.white_pixel_count < config_.min_white_pixels) {
+            background_model_->offer(state.image);
+        }
+    }
+
+    if (config_.filter_white_pixels) {
+        // 如果白色像素面積不在範圍內，直接返回
+        if (!white_pixels_in_range(result.white_pixel_count)) {
+            result.skip_reason = SkipReason::WhitePixelCount;
+            result.preprocess_duration = elapsed_us(state);
+            return false;
+        }
+    }
+
+    if (abort_if_late(state, SkipReason::DeadlineSegment)) {
+        result.preprocess_duration = result.duration;
+        return false;
+    }
+
+    // 已在對焦更好的位置量測過的細胞不做形態學；外接矩形與形態學之後只差幾個像素，在 gate 以內
+    if (tracker && !result.foreground_bounds.empty()) {
+        *decision = tracker->observe(result.foreground_bounds, state.image);
+        result.track_id = decision->track_id;
+        if (!decision->measure) {
+            result.skip_reason = SkipReason::Tracked;
+            result.preprocess_duration = elapsed_us(state);
+            return false;
+        }
+    }
+
+    Mat morphed;
+    if (!run_morphology(binary, morphed, workspace, state.deadline_cycles)) {
+        mark_late(state, SkipReason::DeadlineMorphology);
+        result.preprocess_duration = result.duration;
+        return false;
+    }
+
+    if (config_.use_canny) {
+        Mat edge = workspace_region(workspace.edge, morphed.size());
+        {
+            STAGE_TIMER(Canny);
+            Canny(morphed, edge, 50, 150);
+        }
+        morphed = edge;
+        if (abort_if_late(state, SkipReason::DeadlineMorphology)) {
+            result.preprocess_duration = result.duration;
+            return false;
+        }
+    }
+
+    state.mask = morphed;
+    result.preprocess_duration = elapsed_us(state);
+    return true;
+}
+
+bool CellPipeline::extract_contours(FrameState& state) const {
+    FrameResult& result = state.result;
+
+    auto findcontour_start = chrono::high_resolution_clock::now();
+
+    FrameWorkspace& workspace = workspace_for(state);
+
+    {
+        STAGE_TIMER(Contours);
+        state.traced = false;
+        if (config_.multi_cell && !config_.use_canny) {
+            bool extracted = extract_cells(state, workspace);
+            result.findcontour_duration = chrono::duration<double, micro>(
+                chrono::high_resolution_clock::now() - findcontour_start).count();
+            if (!extracted) {
+                mark_late(state, SkipReason::DeadlineContours);
+                return false;
+            }
+            result.duration = elapsed_us(state);
+            return !abort_if_late(state, SkipReason::DeadlineContours);
+        }
+        if (config_.use_boundary_tracer && config_.retrieval_mode == RETR_LIST && !config_.use_canny) {
+            TracedContour& largest = workspace.largest;
+            int blobs = workspace.tracer.trace_largest(state.mask, largest, state.deadline_cycles);
+            if (blobs < 0) {
+                mark_late(state, SkipReason::DeadlineContours);
+                result.findcontour_duration = chrono::duration<double, micro>(
+                    chrono::high_resolution_clock::now() - findcontour_start).count();
+                return false;
+            }
+            if (blobs <= 1 || !config_.tracer_fallback) {
+                // 以 assign 複製到 result 既有的 vector，容量足夠時不需配置
+                result.contours.resize(blobs > 0 ? 1 : 0);
+                if (blobs > 0) {
+                    vector<Point>& contour = result.contours[0];
+                    contour.assign(largest.points.begin(), largest.points.end());
+                    if (state.roi.x || state.roi.y) {
+                        for (Point& p : contour) {
+                            p += state.roi.tl();
+                        }
+                    }
+                }
+                state.traced = true;
+                state.contour_area = largest.area;
+                state.contour_perimeter = largest.perimeter;
+            }
+        }
+
+        if (!state.traced) {
+            findContours(state.mask, workspace.contours, workspace.hierarchy, config_.retrieval_mode, CHAIN_APPROX_NONE, state.roi.tl());
+            // 交換而不是複製，result 原本的 vector 留給下一次 findContours
+            result.contours.swap(workspace.contours);
+        }
+    }
+
+    auto findcontour_end = chrono::high_resolution_clock::now();
+    result.findcontour_duration = chrono::duration<double, micro>(findcontour_end - findcontour_start).count();
+    result.duration = elapsed_us(state);
+
+    return !abort_if_late(state, SkipReason::DeadlineContours);
+}
+
+// 每個 blob 各自處理，blob 數量少所以 grain 為 1。
+// isolate 避免等待期間去執行外層其他影像的 task (會拿到同一個執行緒的 workspace)
+template <typename Body>
+static void for_each_cell(size_t count, const Body& body) {
+    if (count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+    tbb::this_task_arena::isolate([&]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, count, 1), [&](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                body(i);
+            }
+        });
+    });
+}
+
+bool CellPipeline::extract_cells(FrameState& state, FrameWorkspace& workspace) const {
+    FrameResult& result = state.result;
+    // ROI 模式下 label 影像也使用緩衝區左上角的區域
+    Mat label_image = workspace_region(workspace.labels, state.mask.size(), CV_32S);
+    int labels = connectedComponentsWithStats(state.mask, label_image, workspace.label_stats, workspace.centroids, 8, CV_32S);
+    if (past_deadline(state.deadline_cycles)) {
+        return false;
+    }
+
+    // label 0 為背景，太小的 blob 視為雜訊
+    result.cells.clear();
+    workspace.cell_labels.clear();
+    for (int label = 1; label < labels; ++label) {
+        const int* stats = workspace.label_stats.ptr<int>(label);
+        if (stats[CC_STAT_AREA] < config_.min_cell_pixels) {
+            continue;
+        }
+        CellRecord cell;
+        cell.pixel_count = stats[CC_STAT_AREA];
+        cell.bounds = Rect(stats[CC_STAT_LEFT], stats[CC_STAT_TOP], stats[CC_STAT_WIDTH], stats[CC_STAT_HEIGHT]);
+        cell.bounds += state.roi.tl();
+        result.cells.push_back(cell);
+        workspace.cell_labels.push_back(label);
+    }
+
+    const size_t count = result.cells.size();
+    result.contours.resize(count);
+    if (workspace.cell_contours.size() < count) {
+        workspace.cell_contours.resize(count);
+    }
+    for_each_cell(count, [&](size_t i) {
+        // raster 順序的第一個像素在外接矩形的第一列，8 連通的外輪廓不會走到其他 blob
+        const int label = workspace.cell_labels[i];
+        const int* stats = workspace.label_stats.ptr<int>(label);
+        const int y = stats[CC_STAT_TOP];
+        const int* row = label_image.ptr<int>(y);
+        int x = stats[CC_STAT_LEFT];
+        while (row[x] != label) {
+            ++x;
+        }
+
+        TracedContour& traced = workspace.cell_contours[i];
+        workspace.tracer.trace_outer(state.mask, Point(x, y), traced);
+        vector<Point>& contour = result.contours[i];
+        contour.assign(traced.points.begin(), traced.points.end());
+        if (state.roi.x || state.roi.y) {
+            for (Point& p : contour) {
+                p += state.roi.tl();
+            }
+        }
+        result.cells[i].area = traced.area;
+        result.cells[i].perimeter = traced.perimeter;
+    });
+    return true;
+}
+
+void CellPipeline::compute_cell_metrics(FrameState& state) const {
+    FrameResult& result = state.result;
+    for_each_cell(result.cells.size(), [&](size_t i) {
+        CellRecord& cell = result.cells[i];
+        cell.metrics = contour_metrics(result.contours[i], cell.area, cell.perimeter, config_.circularity);
+    });
+
+    result.largest_contour = -1;
+    for (size_t i = 0; i < result.cells.size(); ++i) {
+        if (result.largest_contour < 0 || result.cells[i].area > result.cells[result.largest_contour].area) {
+            result.largest_contour = static_cast<int>(i);
+        }
+    }
+    if (result.largest_contour >= 0) {
+        result.metrics = result.cells[result.largest_contour].metrics;
+    }
+}
+
+void CellPipeline::compute_metrics(FrameState& state) const {
+    FrameResult& result = state.result;
+    auto metrics_start = chrono::high_resolution_clock::now();
+    STAGE_TIMER(Metrics);
+    vector<Point>* hull = &workspace_for(state).hull;
+    if (config_.multi_cell && !config_.use_canny) {
+        compute_cell_metrics(state);
+    } else if (state.traced && !result.contours.empty()) {
+        result.largest_contour = 0;
+        result.metrics = contour_metrics(result.contours[0], state.contour_area, state.contour_perimeter, config_.circularity, hull);
+    } else if (!result.contours.empty()) {
+        result.metrics = calculate_contour_metrics(result.contours, config_.circularity, &result.largest_contour, hull);
+    }
+    result.processed = true;
+
+    auto metrics_end = chrono::high_resolution_clock::now();
+    result.metrics_duration = chrono::duration<double, micro>(metrics_end - metrics_start).count();
+    result.total_duration = chrono::duration<double, micro>(metrics_end - state.start_time).count();
+}
+
+FrameResult CellPipeline::process(const Mat& image) const {
+    FrameState state;
+    state.image = image;
+    if (image.empty()) {
+        state.result.skip_reason = SkipReason::ReadError;
+        return state.result;
+    }
+
+    if (preprocess(state) && extract_contours(state)) {
+        compute_metrics(state);
+    }
+    return std::move(state.result);
+}
+
+void CellPipeline::process(const Mat& image, FrameWorkspace& workspace, FrameResult& result) const {
+    process(image, workspace, result, nullptr);
+}
+
+void CellPipeline::process(const Mat& image, FrameWorkspace& workspace, FrameResult& result, CellTracker& tracker) const {
+    process(image, workspace, result, &tracker);
+}
+
+void CellPipeline::process(const Mat& image, FrameWorkspace& workspace, FrameResult& result, CellTracker* tracker) const {
+    Size frame_size = config_.crop.empty() ? image.size() : config_.crop.size();
+    if (!image.empty() && frame_size != workspace.frame_size) {
+        workspace.reserve(frame_size);
+    }
+
+    // 先把 result 移入 state，保留其中輪廓 vector 的容量
+    FrameState state;
+    state.workspace = &workspace;
+    state.result = std::move(result);
+    FrameResult& out = state.result;
+    reset_result(out);
+
+    // 輪廓只在 extract_contours 中覆寫，內層 vector 保留給下一張影像使用
+    bool contours_extracted = false;
+    state.image = image;
+    if (tracker) {
+        tracker->begin_frame();
+    }
+    if (image.empty()) {
+        out.skip_reason = SkipReason::ReadError;
+    } else {
+        // 單細胞模式在 preprocess 中 (形態學之前) 配對，多細胞模式在量測後逐個細胞配對
+        bool track_single = tracker && !(config_.multi_cell && !config_.use_canny);
+        TrackDecision decision;
+        if (preprocess(state, track_single ? tracker : nullptr, &decision)) {
+            contours_extracted = true;
+            if (extract_contours(state)) {
+                compute_metrics(state);
+            }
+        }
+
+        if (tracker && out.processed) {
+            if (track_single) {
+                if (decision.track_id >= 0) {
+                    tracker->record(decision, out.metrics);
+                }
+            } else {
+                for (size_t i = 0; i < out.cells.size(); ++i) {
+                    const CellRecord& cell = out.cells[i];
+                    TrackDecision cell_decision = tracker->observe(cell.bounds, state.image);
+                    tracker->record(cell_decision, cell.metrics);
+                    if (static_cast<int>(i) == out.largest_contour) {
+                        out.track_id = cell_decision.track_id;
+                    }
+                }
+            }
+        }
+    }
+    if (!contours_extracted) {
+        out.contours.clear();
+    }
+    result = std::move(state.result);
+}
+
+FrameResult CellPipeline::process_file(const string& image_path) const {
+    Mat image = imread(image_path, IMREAD_GRAYSCALE);
+    return process(image);
+}
+
+void CellPipeline::process_batch(const Mat& frames, int count, FrameWorkspace& workspace, vector<FrameResult>& results) const {
+    results.resize(max(count, 0));
+    if (count <= 0 || frames.empty() || frames.rows % count != 0) {
+        for (FrameResult& out : results) {
+            reset_result(out);
+            out.contours.clear();
+            out.skip_reason = SkipReason::ReadError;
+        }
+        return;
+    }
+
+    const int frame_rows = frames.rows / count;
+    shared_ptr<const Background> background = atomic_load(&background_);
+    Mat first = crop(frames.rowRange(0, frame_rows));
+    bool batched = config_.use_fused_kernel && config_.blur_size == 5 && use_bit_engine() &&
+                   !config_.use_roi && !config_.use_canny && config_.time_limit_us <= 0 &&
+                   frames.type() == CV_8UC1 && background && !first.empty() && first.size() == background->blurred.size();
+    if (!batched) {
+        for (int i = 0; i < count; ++i) {
+            process(frames.rowRange(i * frame_rows, (i + 1) * frame_rows), workspace, results[i]);
+        }
+        return;
+    }
+
+    const Size frame_size = first.size();
+    if (frame_size != workspace.frame_size) {
+        workspace.reserve(frame_size);
+    }
+    const Size stack_size(frame_size.width, frame_size.height * count);
+    const size_t frame_step = frame_rows * frames.step;
+    auto start_time = chrono::high_resolution_clock::now();
+
+    // 整個 stack 一次二值化，每張影像的上下邊界各自補值
+    Mat binary = workspace_region(workspace.batch_binary, stack_size);
+    workspace.batch_foreground.resize(count);
+    {
+        STAGE_TIMER(FusedSegment);
+        const Mat& blurred_bg = background->blurred;
+        fused_blur_subtract_threshold_batch(first.ptr<uchar>(), frames.step, frame_step, blurred_bg.ptr<uchar>(), blurred_bg.step,
+                                            binary.ptr<uchar>(), binary.step, frame_size.width, frame_size.height, count,
+                                            cvFloor(config_.threshold_value), workspace.batch_foreground.data());
+    }
+
+    // 只要有一張影像通過白色像素過濾，整個 stack 一起做形態學，相鄰影像之間視為影像外
+    bool any_accepted = false;
+    for (int i = 0; i < count && !any_accepted; ++i) {
+        any_accepted = !config_.filter_white_pixels || white_pixels_in_range(workspace.batch_foreground[i].count);
+    }
+    Mat morphed = workspace_region(workspace.batch_morphed, stack_size);
+    if (any_accepted) {
+        BitMask& bits = workspace.batch_bits;
+        if (bits.width() != stack_size.width || bits.height() != stack_size.height || bits.frame_height() != frame_size.height) {
+            bits.create(stack_size.width, stack_size.height, frame_size.height);
+        }
+        {
+            STAGE_TIMER(MorphPack);
+            bits.pack(binary);
+        }
+        bits.apply(config_.morphology);
+        STAGE_TIMER(MorphUnpack);
+        bits.unpack(morphed);
+    }
+
+    // 前處理時間平均分攤到每張影像
+    double preprocess_us = chrono::duration<double, micro>(chrono::high_resolution_clock::now() - start_time).count() / count;
+    for (int i = 0; i < count; ++i) {
+        FrameState state;
+        state.workspace = &workspace;
+        state.result = std::move(results[i]);
+        FrameResult& out = state.result;
+        reset_result(out);
+
+        state.image = crop(frames.rowRange(i * frame_rows, (i + 1) * frame_rows));
+        state.roi = Rect(Point(0, 0), frame_size);
+        out.roi = state.roi;
+        out.preprocess_duration = preprocess_us;
+
+        const ForegroundStats& foreground = workspace.batch_foreground[i];
+        out.white_pixel_count = foreground.count;
+        out.foreground_bounds = foreground.bounds;
+        if (background_model_ && foreground.count < config_.min_white_pixels) {
+            background_model_->offer(state.image);
+        }
+
+        if (config_.filter_white_pixels && !white_pixels_in_range(foreground.count)) {
+            out.skip_reason = SkipReason::WhitePixelCount;
+            out.contours.clear();
+        } else {
+            state.mask = morphed.rowRange(i * frame_size.height, (i + 1) * frame_size.height);
+            state.start_time = chrono::high_resolution_clock::now() -
+                               chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double, micro>(preprocess_us));
+            if (extract_contours(state)) {
+                compute_metrics(state);
+            }
+        }
+        results[i] = std::move(state.result);
+    }
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 所有工具共用的細胞分析流程：
+// GaussianBlur -> subtract(背景) -> threshold -> 形態學 -> findContours -> 輪廓指標
+
+struct ContourMetrics {
+    double area_original = 0;
+    double area_hull = 0;
+    double area_ratio = 0;
+    double circularity_original = 0;
+    double circularity_hull = 0;
+    double circularity_ratio = 0;
+};
+
+// 圓度公式：各工具原本使用的兩種寫法
+enum class CircularityFormula {
+    Isoperimetric,   // 4 * pi * A / P^2
+    SqrtIsoperimetric // 2 * sqrt(pi * A) / P
+};
+
+enum class MorphOp {
+    Dilate,
+    Erode
+};
+
+struct MorphStep {
+    MorphOp op;
+    int iterations;
+};
+
+// Deadline* 表示超過 time_limit_us，並記錄是在哪個階段之後發現的
+enum class SkipReason {
+    None,
+    ReadError,
+    WhitePixelCount,
+    DeadlineSegment,    // blur / subtract / threshold 與白色像素過濾之後
+    DeadlineMorphology, // 形態學的任一步 (或 Canny) 之後
+    DeadlineContours,   // 輪廓追蹤中或 findContours 之後
+    Tracked             // 細胞已在對焦更好的影像中量測過 (cell_tracker.h)
+};
+
+const char* skip_reason_name(SkipReason reason);
+bool is_deadline_skip(SkipReason reason);
+
+// 512x96crop.py 對 Test_images/Slight under focus 使用的裁切範圍
+const cv::Rect SLIGHT_UNDER_FOCUS_CROP(220, 45, 512, 96);
+
+struct PipelineConfig {
+    // 非空時只處理影像中的此矩形，取代事先裁切並另存的資料集 (例如 SLIGHT_UNDER_FOCUS_CROP)。
+    // 影像與背景都以 ROI view 取得不複製；模糊以 BORDER_ISOLATED 在裁切邊緣補值，
+    // 結果與先裁切再處理相同。輪廓與 FrameResult::roi 的座標皆相對於裁切範圍
+    cv::Rect crop;
+
+    int blur_size = 5;
+    double threshold_value = 10;
+
+    // blur_size 為 5 時以單次掃描的融合核心取代 GaussianBlur + subtract + threshold
+    bool use_fused_kernel = true;
+
+    // blur_size 為 5 時背景與非融合路徑的模糊以整數 separable 核心取代 GaussianBlur，結果逐位元相同 (fused_threshold.h)
+    bool use_integer_blur = true;
+
+    // 白色像素面積不在範圍內的影像在形態學之前直接跳過。
+    // 白色像素數由融合核心在二值化時順便算出，其他路徑才另外 countNonZero；範圍依資料集調整
+    bool filter_white_pixels = true;
+    int min_white_pixels = 250;
+    int max_white_pixels = 650;
+
+    // 3x3 MORPH_CROSS，依序執行
+    std::vector<MorphStep> morphology = {
+        {MorphOp::Dilate, 2},
+        {MorphOp::Erode, 3},
+        {MorphOp::Dilate, 1}
+    };
+
+    // 以 bit-packed 引擎執行整串形態學運算 (binary_morphology.h)
+    bool use_bit_morphology = true;
+
+    // 結構元素的錨點，(-1, -1) 為中心。非中心時 bit-packed 與固定大小的引擎不支援，改用 OpenCV dilate / erode
+    // (thread_num 沿用原本的 Point() 即 (0, 0)，mask 與輪廓會往右下偏移)
+    cv::Point morph_anchor = cv::Point(-1, -1);
+
+    // 影像大小為資料集的固定大小時，bit-packed 形態學改用以寬高為模板參數的特化版本 (fixed_geometry.h)
+    bool use_fixed_geometry = true;
+
+    // RETR_LIST 且未使用 Canny 時，以單一物體 tracer 取代 findContours (contour_tracer.h)；
+    // tracer_fallback 開啟時，若畫面中有多個 blob 則改用 findContours
+    bool use_boundary_tracer = true;
+    bool tracer_fallback = false;
+
+    // 多細胞模式：以 connectedComponentsWithStats 一次標記所有 blob，每個 blob 各自追蹤外輪廓並計算指標，
+    // 每個細胞輸出一筆 CellRecord，不再只保留最大的輪廓。白色像素上限放寬為 max_white_pixels * max_cells，
+    // 少於 min_cell_pixels 的 blob 視為雜訊。use_canny 時無效
+    bool multi_cell = false;
+    int max_cells = 4;
+    int min_cell_pixels = 50;
+
+    bool use_canny = false;
+    int retrieval_mode = cv::RETR_LIST;
+    CircularityFormula circularity = CircularityFormula::Isoperimetric;
+
+    // 兩階段處理：先以縮小 roi_scale 倍的影像與背景相減，找出差值超過 roi_threshold 的外接矩形，
+    // 之後只對該矩形 (四周加上 roi_margin 像素) 執行完整流程，處理時間隨細胞大小而非影像大小變化。
+    // roi_margin 需大於模糊半徑加上形態學的擴張量 (模糊在 ROI 邊緣以 REFLECT_101 補值，
+    // 與整張影像的結果只在邊緣 2 像素內不同)；白色像素只計算 ROI 內的部分。
+    // 粗略偵測沒有找到前景時，若白色像素過濾開啟則直接跳過，否則處理整張影像
+    bool use_roi = false;
+    int roi_scale = 4;
+    double roi_threshold = 5;  // 縮小後細胞邊緣與背景平均，差值較原本的 threshold_value 小
+    int roi_margin = 8;
+
+    // 超過此處理時間(微秒)即放棄該影像，0 表示不限制。
+    // 每個階段之間 (包含每一步形態學與 tracer 的每個 blob) 以 cycle counter 檢查，超過即中止
+    double time_limit_us = 0;
+};
+
+// 多細胞模式中的一個細胞，輪廓為 FrameResult::contours 中相同索引的輪廓
+struct CellRecord {
+    int pixel_count = 0; // 形態學之後該 blob 的像素數
+    cv::Rect bounds;
+    double area = 0;     // 外輪廓的 contourArea
+    double perimeter = 0;
+    ContourMetrics metrics;
+};
+
+struct FrameResult {
+    bool processed = false;
+    SkipReason skip_reason = SkipReason::None;
+    int white_pixel_count = 0;
+    cv::Rect foreground_bounds;      // 二值化後白色像素的外接矩形，只在計算白色像素時有值
+    std::vector<std::vector<cv::Point>> contours;
+    int largest_contour = -1;
+    ContourMetrics metrics;          // 多細胞模式中為最大細胞的指標
+    std::vector<CellRecord> cells;   // 只在多細胞模式中有值
+    int track_id = -1;               // 經由 CellTracker 處理時，最大 (或唯一) 細胞所屬的 track
+    cv::Rect roi;                    // 實際處理的區域，輪廓座標仍為整張影像的座標
+    double duration = 0;             // blur 到 findContours 的時間(微秒)
+    double findcontour_duration = 0; // findContours 本身的時間(微秒)
+    double preprocess_duration = 0;  // blur 到形態學 (含白色像素過濾) 的時間(微秒)
+    double metrics_duration = 0;     // 凸包與圓度的時間(微秒)
+    double total_duration = 0;       // blur 到指標計算完成的時間(微秒)，只在 processed 時有值
+};
+
+struct FrameWorkspace;
+struct ForegroundStats;
+class BackgroundModel;
+class CellTracker;
+struct TrackDecision;
+
+// 單張影像在各階段之間傳遞的狀態
+struct FrameState {
+    FrameState();
+    ~FrameState();
+    FrameState(FrameState&&);
+    FrameState& operator=(FrameState&&);
+
+    // 清除上一張影像的結果以重複使用同一個 FrameState，workspace 不變
+    void reset();
+
+    cv::Mat image;
+    cv::Mat mask;                    // roi 範圍內的前景
+    cv::Rect roi;
+    std::chrono::high_resolution_clock::time_point start_time;
+    FrameResult result;
+
+    // tracer 已算出最大輪廓的面積與周長時，result.contours 只包含該輪廓
+    bool traced = false;
+    double contour_area = 0;
+    double contour_perimeter = 0;
+
+    // 非 nullptr 時各階段的中間結果寫入此 workspace (frame_workspace.h)；
+    // 否則第一次需要時建立 owned_workspace，同一張影像的各階段共用 (CellPipeline::workspace_for)
+    FrameWorkspace* workspace = nullptr;
+    std::unique_ptr<FrameWorkspace> owned_workspace;
+
+    // read_cycles() 的期限 (stage_timer.h)，0 表示不限制。
+    // 呼叫端可在 preprocess 前自行設定 (例如依取像時間)，否則由 time_limit_us 決定
+    uint64_t deadline_cycles = 0;
+};
+
+// 由單一輪廓與其已知的面積、周長計算指標
+// hull_buffer 非 nullptr 時重複使用該 vector 作為凸包的暫存區 (convex_hull.h)
+ContourMetrics contour_metrics(const std::vector<cv::Point>& contour, double area, double perimeter,
+                               CircularityFormula formula = CircularityFormula::Isoperimetric,
+                               std::vector<cv::Point>* hull_buffer = nullptr);
+
+// 面積最大的輪廓的索引 (面積相同時取第一個)，沒有輪廓時回傳 -1。
+// 每個輪廓只計算一次 contourArea，area 非 nullptr 時輸出該輪廓的面積
+int largest_contour(const std::vector<std::vector<cv::Point>>& contours, double* area = nullptr);
+
+// 以面積最大的輪廓計算指標，面積沿用選擇時算出的值
+ContourMetrics calculate_contour_metrics(const std::vector<std::vector<cv::Point>>& contours,
+                                         CircularityFormula formula = CircularityFormula::Isoperimetric,
+                                         int* largest_index = nullptr,
+                                         std::vector<cv::Point>* hull_buffer = nullptr);
+
+class CellPipeline {
+public:
+    explicit CellPipeline(const PipelineConfig& config = PipelineConfig());
+
+    const PipelineConfig& config() const { return config_; }
+
+    // 背景只需模糊一次，之後所有影像共用。
+    // set_background 以 atomic 方式替換，可在其他執行緒處理影像時由 BackgroundModel 呼叫
+    // 設定 crop 時 background 可以是整張影像或已裁切的影像
+    bool load_background(const std::string& background_path);
+    void set_background(const cv::Mat& background);
+    cv::Mat blurred_background() const;
+
+    // config.crop 範圍的 view (不複製)，未設定 crop 時回傳 frame，影像容不下裁切範圍時回傳空 Mat
+    cv::Mat crop(const cv::Mat& frame) const;
+
+    // 白色像素少於 min_white_pixels 的空影像 (已裁切) 交給此背景模型更新背景 (background_model.h)，nullptr 表示不更新
+    void set_background_model(BackgroundModel* model) { background_model_ = model; }
+
+    // blur + subtract + threshold，輸出二值化影像。
+    // foreground 非 nullptr 時一併輸出白色像素數與外接矩形 (fused_threshold.h)
+    void segment(const cv::Mat& image, cv::Mat& binary, ForegroundStats* foreground = nullptr) const;
+    void segment(const cv::Mat& image, cv::Mat& binary, FrameWorkspace& workspace, ForegroundStats* foreground = nullptr) const;
+
+    // 依 config.morphology 依序執行 3x3 MORPH_CROSS 的 dilate / erode
+    void morphology(const cv::Mat& binary, cv::Mat& morphed) const;
+    void morphology(const cv::Mat& binary, cv::Mat& morphed, FrameWorkspace& workspace) const;
+
+    // 處理已解碼的影像，計時不包含讀檔
+    FrameResult process(const cv::Mat& image) const;
+    // 使用呼叫端的 workspace，並重複使用 result 原有的輪廓緩衝區
+    void process(const cv::Mat& image, FrameWorkspace& workspace, FrameResult& result) const;
+    // 同上，並把偵測到的細胞交給 tracker 串成 track。影像需依取像順序逐張傳入。
+    // 單細胞模式在二值化之後、形態學之前以前景的外接矩形配對，若該 track 已在對焦更好的位置量測過
+    // 或已離開焦平面，跳過形態學、輪廓與指標 (SkipReason::Tracked)；多細胞模式仍完整量測每張影像，只做配對
+    void process(const cv::Mat& image, FrameWorkspace& workspace, FrameResult& result, CellTracker& tracker) const;
+    FrameResult process_file(const std::string& image_path) const;
+
+    // 一次處理 count 張上下相接的影像 (CV_8UC1，rows 為 count 乘以單張高度，例如 FrameStackReader::frames)，
+    // results[i] 對應第 i 張。融合核心與 bit-packed 形態學對整個 stack 各只呼叫一次，
+    // 之後逐張追蹤輪廓與計算指標；preprocess_duration 為整個 stack 的前處理時間平均分攤到每張。
+    // 不符合 stack 處理條件 (未使用融合核心或 bit-packed 形態學、use_roi、use_canny、time_limit_us) 時逐張 process
+    void process_batch(const cv::Mat& frames, int count, FrameWorkspace& workspace, std::vector<FrameResult>& results) const;
+
+    // 分階段介面，供 pipeline 模式使用；回傳 false 表示該影像已被跳過
+    bool decode(const std::string& image_path, FrameState& state) const;
+    bool preprocess(FrameState& state) const;
+    bool extract_contours(FrameState& state) const;
+    void compute_metrics(FrameState& state) const;
+
+private:
+    void process(const cv::Mat& image, FrameWorkspace& workspace, FrameResult& result, CellTracker* tracker) const;
+    // state.workspace，沒有時為 state 自己的 owned_workspace
+    FrameWorkspace& workspace_for(FrameState& state) const;
+    // tracker 非 nullptr 時在二值化之後以前景外接矩形配對，結果寫入 decision (沒有前景時 track_id 為 -1)
+    bool preprocess(FrameState& state, CellTracker* tracker, TrackDecision* decision) const;
+    // 白色像素過濾的範圍 (多細胞模式放寬上限)
+    bool white_pixels_in_range(int count) const;
+
+    // 多細胞模式的 extract_contours / compute_metrics
+    bool extract_cells(FrameState& state, FrameWorkspace& workspace) const;
+    void compute_cell_metrics(FrameState& state) const;
+
+    // 同一次發佈的模糊背景與供 ROI 粗略偵測使用的縮小背景
+    struct Background {
+        cv::Mat blurred;
+        cv::Mat coarse;
+    };
+
+    // blur_size x blur_size 的 GaussianBlur (BORDER_ISOLATED)，符合條件時改用 gaussian_blur_5x5
+    void blur_image(const cv::Mat& image, cv::Mat& blurred) const;
+    void segment(const cv::Mat& image, const cv::Mat& blurred_bg, cv::Mat& binary, FrameWorkspace& workspace,
+                 ForegroundStats* foreground) const;
+    // 回傳 false 表示沒有找到前景
+    bool find_roi(const cv::Mat& image, const Background& background, FrameWorkspace& workspace, cv::Rect& roi) const;
+
+    // use_bit_morphology 且錨點在中心時使用 bit-packed 引擎
+    bool use_bit_engine() const;
+    // deadline_cycles 不為 0 時，每一步之間檢查是否超時，超時回傳 false
+    bool run_morphology(const cv::Mat& binary, cv::Mat& morphed, FrameWorkspace& workspace, uint64_t deadline_cycles) const;
+
+    PipelineConfig config_;
+    uint64_t budget_cycles_ = 0;
+    cv::Mat kernel_;
+    // 只透過 std::atomic_load / atomic_store 存取，已發佈的背景不會再被修改
+    std::shared_ptr<const Background> background_;
+    BackgroundModel* background_model_ = nullptr;
+};
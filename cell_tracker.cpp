@@ -0,0 +1,155 @@
+#include "cell_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace cv;
+using namespace std;
+
+static Point2d rect_center(const Rect& r) {
+    return Point2d(r.x + r.width * 0.5, r.y + r.height * 0.5);
+}
+
+CellTracker::CellTracker(const TrackerConfig& config) : config_(config) {}
+
+CellTrack* CellTracker::find(int track_id) {
+    for (CellTrack& track : active_) {
+        if (track.id == track_id) {
+            return &track;
+        }
+    }
+    return nullptr;
+}
+
+void CellTracker::begin_frame() {
+    frame_++;
+    matched_.clear();
+
+    // 依原本順序移到 finished_，結束的 track 依最後出現的影像排序
+    size_t kept = 0;
+    for (size_t i = 0; i < active_.size(); ++i) {
+        if (frame_ - active_[i].last_frame > config_.max_missed) {
+            finished_.push_back(active_[i]);
+        } else {
+            if (kept != i) {
+                active_[kept] = active_[i];
+            }
+            kept++;
+        }
+    }
+    active_.resize(kept);
+}
+
+TrackDecision CellTracker::observe(const Rect& bounds, const Mat& image) {
+    Point2d center = rect_center(bounds);
+
+    CellTrack* best = nullptr;
+    double best_distance = 0;
+    for (CellTrack& track : active_) {
+        if (std::find(matched_.begin(), matched_.end(), track.id) != matched_.end()) {
+            continue;
+        }
+        int frames = frame_ - track.last_frame;
+        Point2d predicted = track.center + track.velocity * frames;
+        double dx = center.x - predicted.x;
+        double dy = center.y - predicted.y;
+        if (std::abs(dy) > config_.gate) {
+            continue;
+        }
+        if (track.appearances == 1) {
+            // 速度未知 (velocity 仍為 initial_velocity)：只要求比預測位置往下游多移動不超過 max_displacement
+            if (dx < -config_.gate || dx > config_.max_displacement * frames) {
+                continue;
+            }
+        } else if (std::abs(dx) > config_.gate) {
+            continue;
+        }
+        double distance = dx * dx + dy * dy;
+        if (!best || distance < best_distance) {
+            best = &track;
+            best_distance = distance;
+        }
+    }
+
+    TrackDecision decision;
+    if (!best) {
+        CellTrack track;
+        track.id = next_id_++;
+        track.first_frame = frame_;
+        track.last_frame = frame_;
+        track.appearances = 1;
+        track.bounds = bounds;
+        track.center = center;
+        track.velocity = config_.initial_velocity;
+        active_.push_back(track);
+        matched_.push_back(track.id);
+        decision.track_id = track.id;
+        decision.measure = true;
+        decision.focus = focus_score(image, bounds);
+        return decision;
+    }
+
+    Point2d displacement = (center - best->center) * (1.0 / (frame_ - best->last_frame));
+    if (best->appearances == 1) {
+        best->velocity = displacement;
+    } else {
+        best->velocity = best->velocity * (1 - config_.velocity_smoothing) + displacement * config_.velocity_smoothing;
+    }
+    best->bounds = bounds;
+    best->center = center;
+    best->last_frame = frame_;
+    best->appearances++;
+    matched_.push_back(best->id);
+
+    decision.track_id = best->id;
+    if (best->settled) {
+        decision.measure = false;
+        return decision;
+    }
+    decision.focus = focus_score(image, bounds);
+    if (best->best_focus >= 0 && decision.focus < best->best_focus * config_.settle_ratio) {
+        best->settled = true;
+    }
+    decision.measure = best->best_focus < 0 || decision.focus > best->best_focus * config_.focus_gain;
+    return decision;
+}
+
+void CellTracker::record(const TrackDecision& decision, const ContourMetrics& metrics) {
+    CellTrack* track = find(decision.track_id);
+    if (!track) {
+        return;
+    }
+    track->measurements++;
+    if (decision.focus > track->best_focus) {
+        track->best_focus = decision.focus;
+        track->best_frame = frame_;
+        track->metrics = metrics;
+    }
+}
+
+void CellTracker::finish() {
+    finished_.insert(finished_.end(), active_.begin(), active_.end());
+    active_.clear();
+    matched_.clear();
+}
+
+double focus_score(const Mat& image, const Rect& bounds) {
+    CV_Assert(image.type() == CV_8UC1);
+    Rect r = bounds & Rect(0, 0, image.cols, image.rows);
+    if (r.width < 2 || r.height < 2) {
+        return 0;
+    }
+
+    int64_t sum = 0;
+    for (int y = r.y; y < r.y + r.height - 1; ++y) {
+        const uchar* row = image.ptr<uchar>(y) + r.x;
+        const uchar* next = image.ptr<uchar>(y + 1) + r.x;
+        for (int x = 0; x < r.width - 1; ++x) {
+            int dx = row[x + 1] - row[x];
+            int dy = next[x] - row[x];
+            sum += dx * dx + dy * dy;
+        }
+    }
+    return static_cast<double>(sum) / ((r.width - 1) * (r.height - 1));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "cell_pipeline.h"
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+struct TrackerConfig {
+    // 細胞沿通道 (x 方向) 移動，第一次配對前以 initial_velocity (像素/張) 預測位置，
+    // 之後以實際位移的指數移動平均更新
+    cv::Point2d initial_velocity = cv::Point2d(0, 0);
+    double velocity_smoothing = 0.5;
+
+    // 偵測中心與預測中心的距離在 gate 以內才配對；只出現過一次的 track 速度未知，
+    // x 方向改為允許預測位置 (上一次位置 + initial_velocity) 之後 [-gate, max_displacement] 的誤差，
+    // 因此 initial_velocity.x 應設為流速的下限
+    double gate = 16;
+    double max_displacement = 160;
+
+    // 連續 max_missed 張沒有配對到的 track 結束
+    int max_missed = 1;
+
+    // 對焦分數超過目前最佳值的 focus_gain 倍才重新完整量測
+    double focus_gain = 1.05;
+    // 已量測的 track 對焦分數低於最佳值的 settle_ratio 倍時視為已離開焦平面，之後不再計算對焦分數也不再量測
+    double settle_ratio = 0.8;
+};
+
+// 一個細胞在連續影像中的出現紀錄
+struct CellTrack {
+    int id = -1;
+    int first_frame = 0;
+    int last_frame = 0;
+    int appearances = 0;
+    int measurements = 0;       // 完整量測 (輪廓 + 指標) 的次數
+    cv::Rect bounds;            // 最後一次出現的外接矩形
+    cv::Point2d center;
+    cv::Point2d velocity;       // 像素/張
+    double best_focus = -1;     // 已量測的出現中最高的對焦分數，未量測時為 -1
+    int best_frame = -1;
+    bool settled = false;       // 已通過最佳對焦位置 (TrackerConfig::settle_ratio)
+    ContourMetrics metrics;     // best_frame 的指標
+};
+
+struct TrackDecision {
+    int track_id = -1;   // -1 表示沒有配對 (沒有前景)
+    bool measure = true; // false 表示該 track 已在對焦更好的位置量測過，可跳過形態學、輪廓與指標
+    double focus = -1;   // 沒有計算對焦分數 (track 已 settled) 時為 -1
+};
+
+// 以外接矩形中心與預測位移把每張影像的偵測串成 track，讓每個細胞只在對焦最好的位置量測。
+// 影像必須依取像順序逐張交給 tracker，只能由一個執行緒使用
+class CellTracker {
+public:
+    explicit CellTracker(const TrackerConfig& config = TrackerConfig());
+
+    const TrackerConfig& config() const { return config_; }
+
+    // 開始下一張影像：結束太久沒有出現的 track
+    void begin_frame();
+    // 把一個偵測 (image 中的外接矩形) 配對到預測位置最近的 track，沒有則建立新的 track。
+    // 只有仍可能需要量測的 track (新的或尚未 settled) 才計算 focus_score
+    TrackDecision observe(const cv::Rect& bounds, const cv::Mat& image);
+    // 完整量測後呼叫，對焦較好時取代該 track 的指標
+    void record(const TrackDecision& decision, const ContourMetrics& metrics);
+    // 結束所有進行中的 track
+    void finish();
+
+    int frame() const { return frame_; }
+    const std::vector<CellTrack>& active() const { return active_; }
+    const std::vector<CellTrack>& finished() const { return finished_; }
+
+private:
+    CellTrack* find(int track_id);
+
+    TrackerConfig config_;
+    int frame_ = -1;
+    int next_id_ = 0;
+    std::vector<CellTrack> active_;
+    std::vector<CellTrack> finished_;
+    std::vector<int> matched_; // 本張影像已配對的 track id
+};
+
+// bounds 內相鄰像素差平方的平均 (水平 + 垂直)，越清楚越大
+double focus_score(const cv::Mat& image, const cv::Rect& bounds);
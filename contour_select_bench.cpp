@@ -0,0 +1,64 @@
+#include "cell_pipeline.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 在有許多小輪廓的影像上比較兩種選擇最大輪廓的方式：
+// 比較函式中重算 contourArea 的 max_element + 複製輪廓，與每個輪廓只算一次面積並保留索引
+// 用法: contour_select_bench [重複次數]
+int main(int argc, char** argv) {
+    const int repetitions = argc > 1 ? atoi(argv[1]) : 1000;
+    const Size frame_size(512, 96);
+    const int blob_counts[] = {1, 10, 50, 200, 500};
+    mt19937 rng(12345);
+
+    cout << "blobs  contours  max_element + copy (us)  single pass (us)" << endl;
+    for (int blobs : blob_counts) {
+        // 隨機散布 1~4 像素半徑的小點，外加一個細胞大小的 blob
+        Mat mask = Mat::zeros(frame_size, CV_8UC1);
+        uniform_int_distribution<int> x_dist(0, frame_size.width - 1), y_dist(0, frame_size.height - 1), r_dist(1, 4);
+        for (int i = 0; i < blobs - 1; ++i) {
+            circle(mask, Point(x_dist(rng), y_dist(rng)), r_dist(rng), Scalar(255), FILLED);
+        }
+        circle(mask, Point(x_dist(rng), y_dist(rng)), 12, Scalar(255), FILLED);
+
+        vector<vector<Point>> contours;
+        findContours(mask, contours, RETR_LIST, CHAIN_APPROX_NONE);
+
+        // 兩種方式的結果都累加起來，避免迴圈被最佳化掉
+        double old_sum = 0, new_sum = 0;
+        int old_index = -1, new_index = -1;
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            auto largest = max_element(contours.begin(), contours.end(),
+                                       [](const auto& c1, const auto& c2) { return contourArea(c1) < contourArea(c2); });
+            vector<Point> cnt = *largest;
+            old_sum += contourArea(cnt) + arcLength(cnt, true);
+            old_index = static_cast<int>(largest - contours.begin());
+        }
+        auto middle = chrono::high_resolution_clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            double area = 0;
+            new_index = largest_contour(contours, &area);
+            new_sum += area + arcLength(contours[new_index], true);
+        }
+        auto end = chrono::high_resolution_clock::now();
+
+        double old_us = chrono::duration<double, micro>(middle - start).count() / repetitions;
+        double new_us = chrono::duration<double, micro>(end - middle).count() / repetitions;
+        cout << blobs << "  " << contours.size() << "  " << old_us << "  " << new_us;
+        // 兩種方式選到的輪廓必須相同
+        if (old_index != new_index || old_sum != new_sum) {
+            cout << "  (mismatch)";
+        }
+        cout << endl;
+    }
+
+    return 0;
+}
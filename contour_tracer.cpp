@@ -0,0 +1,132 @@
+#include "contour_tracer.h"
+#include "stage_timer.h"
+
+#include <cmath>
+#include <cstdint>
+
+using namespace cv;
+using namespace std;
+
+// findContours 使用的鏈碼方向，編號遞增為逆時針
+static const Point code_deltas[8] = {
+    Point(1, 0), Point(1, -1), Point(0, -1), Point(-1, -1),
+    Point(-1, 0), Point(-1, 1), Point(0, 1), Point(1, 1)
+};
+
+static inline bool foreground(const Mat& mask, Point p) {
+    return p.x >= 0 && p.y >= 0 && p.x < mask.cols && p.y < mask.rows && mask.ptr<uchar>(p.y)[p.x] != 0;
+}
+
+void BoundaryTracer::trace_outer(const Mat& mask, Point start, TracedContour& contour) const {
+    contour.points.clear();
+    contour.area = 0;
+    contour.perimeter = 0;
+
+    // 從左側 (方向 4) 開始順時針找第一個前景鄰居 i1
+    Point i0 = start, i1;
+    int s = 4;
+    const int s_end = 4;
+    do {
+        s = (s - 1) & 7;
+        i1 = i0 + code_deltas[s];
+    } while (!foreground(mask, i1) && s != s_end);
+
+    if (s == s_end) {
+        // 單一孤立像素
+        contour.points.push_back(i0);
+        return;
+    }
+
+    int64_t twice_area = 0;
+    int axis_steps = 0, diagonal_steps = 0;
+    Point i3 = i0, i4;
+    for (;;) {
+        // 從上一個方向的下一格開始逆時針找下一個前景像素
+        int k = 1;
+        for (; k <= 8; ++k) {
+            i4 = i3 + code_deltas[(s + k) & 7];
+            if (foreground(mask, i4)) {
+                break;
+            }
+        }
+        s = (s + k) & 7;
+
+        contour.points.push_back(i3);
+        twice_area += static_cast<int64_t>(i3.x) * i4.y - static_cast<int64_t>(i3.y) * i4.x;
+        if (s & 1) {
+            diagonal_steps++;
+        } else {
+            axis_steps++;
+        }
+
+        if (i4 == i0 && i3 == i1) {
+            break;
+        }
+        i3 = i4;
+        s = (s + 4) & 7;
+    }
+
+    contour.area = std::abs(static_cast<double>(twice_area)) * 0.5;
+    // arcLength 以 float 計算每段長度
+    contour.perimeter = axis_steps + diagonal_steps * static_cast<double>(std::sqrt(2.0f));
+}
+
+void BoundaryTracer::fill_blob(const Mat& mask, Point seed) {
+    stack_.clear();
+    stack_.push_back(seed);
+    visited_.ptr<uchar>(seed.y)[seed.x] = 1;
+
+    while (!stack_.empty()) {
+        Point p = stack_.back();
+        stack_.pop_back();
+        for (const Point& d : code_deltas) {
+            Point q = p + d;
+            if (foreground(mask, q) && !visited_.ptr<uchar>(q.y)[q.x]) {
+                visited_.ptr<uchar>(q.y)[q.x] = 1;
+                stack_.push_back(q);
+            }
+        }
+    }
+}
+
+void BoundaryTracer::reserve(Size size, size_t max_points) {
+    visited_buffer_.create(size, CV_8UC1);
+    stack_.reserve(static_cast<size_t>(size.area()));
+    current_.points.reserve(max_points);
+}
+
+int BoundaryTracer::trace_largest(const Mat& mask, TracedContour& largest, uint64_t deadline_cycles) {
+    CV_Assert(mask.type() == CV_8UC1);
+    if (visited_buffer_.cols < mask.cols || visited_buffer_.rows < mask.rows) {
+        visited_buffer_.create(mask.size(), CV_8UC1);
+    }
+    visited_ = visited_buffer_(Rect(0, 0, mask.cols, mask.rows));
+    visited_ = Scalar(0);
+
+    largest.points.clear();
+    largest.area = 0;
+    largest.perimeter = 0;
+
+    int blobs = 0;
+    for (int y = 0; y < mask.rows; ++y) {
+        const uchar* row = mask.ptr<uchar>(y);
+        const uchar* seen = visited_.ptr<uchar>(y);
+        for (int x = 0; x < mask.cols; ++x) {
+            if (!row[x] || seen[x]) {
+                continue;
+            }
+
+            // raster 順序中第一個未標記的前景像素必為該 blob 外輪廓的起點
+            trace_outer(mask, Point(x, y), current_);
+            if (blobs == 0 || current_.area > largest.area) {
+                swap(largest, current_);
+            }
+            fill_blob(mask, Point(x, y));
+            blobs++;
+            if (deadline_cycles && read_cycles() > deadline_cycles) {
+                return -1;
+            }
+        }
+    }
+    return blobs;
+}
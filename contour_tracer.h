@@ -0,0 +1,37 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+struct TracedContour {
+    std::vector<cv::Point> points;
+    double area = 0;      // 與 contourArea 相同 (shoelace)
+    double perimeter = 0; // 與 arcLength(points, true) 相同
+};
+
+// 只追蹤單一物體外輪廓的 tracer，取代 findContours(RETR_LIST, CHAIN_APPROX_NONE) + 取最大輪廓。
+// 每個 blob 從 raster 順序的第一個前景像素出發，以 Suzuki 的外輪廓追蹤規則 (與 findContours 相同)
+// 走一圈，邊走邊累計 shoelace 面積與周長；之後以 8 連通 flood fill 標記整個 blob 再找下一個。
+// 緩衝區在多次呼叫間重複使用。
+class BoundaryTracer {
+public:
+    // mask 為 CV_8UC1，非 0 視為前景。回傳 blob 數量，largest 為外輪廓面積最大的 blob。
+    // deadline_cycles 不為 0 時每個 blob 之後檢查 read_cycles()，超過即回傳 -1
+    int trace_largest(const cv::Mat& mask, TracedContour& largest, uint64_t deadline_cycles = 0);
+
+    // 從 start (raster 順序中 blob 的第一個像素) 追蹤該 blob 的外輪廓，同時算出面積與周長。
+    // 只讀取 mask，可由多個執行緒同時呼叫
+    void trace_outer(const cv::Mat& mask, cv::Point start, TracedContour& contour) const;
+
+    // 預先配置 visited 影像、flood fill 堆疊與輪廓點緩衝區；之後較小的 mask 不需重新配置
+    void reserve(cv::Size size, size_t max_points);
+
+private:
+    void fill_blob(const cv::Mat& mask, cv::Point seed);
+
+    cv::Mat visited_buffer_;
+    cv::Mat visited_; // visited_buffer_ 中與目前 mask 同大小的區域
+    std::vector<cv::Point> stack_;
+    TracedContour current_;
+};
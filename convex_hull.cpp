@@ -0,0 +1,99 @@
+#include "convex_hull.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+using namespace cv;
+using namespace std;
+
+// > 0：o -> a -> b 為左轉
+static inline int64_t cross(Point o, Point a, Point b) {
+    return static_cast<int64_t>(a.x - o.x) * (b.y - o.y) - static_cast<int64_t>(a.y - o.y) * (b.x - o.x);
+}
+
+// arcLength 以 float 計算每段長度，累加為 double
+static inline double edge_length(Point a, Point b) {
+    float dx = static_cast<float>(b.x - a.x), dy = static_cast<float>(b.y - a.y);
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// 加入 p 之前先移除不再是左轉的頂點，stack[floor] 以下不動
+static inline void push_hull(Point* stack, int& size, int floor, Point p) {
+    while (size >= floor + 2 && cross(stack[size - 2], stack[size - 1], p) <= 0) {
+        --size;
+    }
+    stack[size++] = p;
+}
+
+HullMetrics convex_hull_metrics(const Point* points, int count, Point* buffer) {
+    if (count <= 0) {
+        return HullMetrics();
+    }
+
+    int min_x = points[0].x, max_x = points[0].x;
+    for (int i = 1; i < count; ++i) {
+        min_x = min(min_x, points[i].x);
+        max_x = max(max_x, points[i].x);
+    }
+    const int width = max_x - min_x + 1;
+
+    // columns[x - min_x] = (該行最小 y, 最大 y)，沒有點的行為 (INT_MAX, INT_MIN)
+    Point* columns = buffer;
+    for (int i = 0; i < width; ++i) {
+        columns[i] = Point(INT_MAX, INT_MIN);
+    }
+    for (int i = 0; i < count; ++i) {
+        Point& range = columns[points[i].x - min_x];
+        range.x = min(range.x, points[i].y);
+        range.y = max(range.y, points[i].y);
+    }
+
+    // 由左到右走每一行的最小 y，再由右到左走最大 y，回到起點
+    Point* hull = buffer + width;
+    int size = 0;
+    for (int i = 0; i < width; ++i) {
+        if (columns[i].x != INT_MAX) {
+            push_hull(hull, size, 0, Point(min_x + i, columns[i].x));
+        }
+    }
+    if (columns[width - 1].y != columns[width - 1].x) {
+        push_hull(hull, size, 0, Point(max_x, columns[width - 1].y));
+    }
+    const int lower = size - 1;
+    for (int i = width - 2; i >= 0; --i) {
+        if (columns[i].x != INT_MAX) {
+            push_hull(hull, size, lower, Point(min_x + i, columns[i].y));
+        }
+    }
+    push_hull(hull, size, lower, hull[0]);
+
+    // hull[size - 1] 與 hull[0] 相同，走一圈同時累計 shoelace 面積與周長
+    HullMetrics metrics;
+    metrics.vertices = max(size - 1, 1);
+    int64_t twice_area = 0;
+    for (int i = 0; i + 1 < size; ++i) {
+        Point a = hull[i], b = hull[i + 1];
+        twice_area += static_cast<int64_t>(a.x) * b.y - static_cast<int64_t>(a.y) * b.x;
+        metrics.perimeter += edge_length(a, b);
+    }
+    metrics.area = std::abs(static_cast<double>(twice_area)) * 0.5;
+    return metrics;
+}
+
+HullMetrics convex_hull_metrics(const vector<Point>& contour, vector<Point>* buffer) {
+    if (contour.empty()) {
+        return HullMetrics();
+    }
+    auto x_range = minmax_element(contour.begin(), contour.end(), [](const Point& a, const Point& b) { return a.x < b.x; });
+    const size_t needed = 3 * static_cast<size_t>(x_range.second->x - x_range.first->x + 1) + 2;
+    if (buffer) {
+        if (buffer->size() < needed) {
+            buffer->resize(needed);
+        }
+        return convex_hull_metrics(contour.data(), static_cast<int>(contour.size()), buffer->data());
+    }
+    AutoBuffer<Point, 1024> local(needed);
+    return convex_hull_metrics(contour.data(), static_cast<int>(contour.size()), local.data());
+}
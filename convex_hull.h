@@ -0,0 +1,20 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+struct HullMetrics {
+    double area = 0;      // 與 contourArea(hull) 相同
+    double perimeter = 0; // 與 arcLength(hull, true) 相同 (加總順序不同，只差捨入誤差)
+    int vertices = 0;
+};
+
+// 整數座標輪廓的線性時間凸包，同時算出凸包的面積與周長，不產生凸包的 vector。
+// 凸包的頂點必為所在 x 行的最高或最低點，因此先記錄每一行的 y 範圍 (取代排序)，
+// 再以 Andrew monotone chain 由左到右、由右到左各走一次。共線的點不保留在凸包上。
+// buffer 由呼叫端提供，至少 3 * (max_x - min_x + 1) + 2 個 Point；
+// 8 連通的輪廓每一行都至少有一個點，因此 3 * count + 2 即足夠
+HullMetrics convex_hull_metrics(const cv::Point* points, int count, cv::Point* buffer);
+
+// buffer 非 nullptr 時重複使用，只在容量不足時成長；否則使用堆疊上的緩衝區
+HullMetrics convex_hull_metrics(const std::vector<cv::Point>& contour, std::vector<cv::Point>* buffer = nullptr);
@@ -1,3 +1,4 @@
+#include "cell_pipeline.h"
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <cmath>
@@ -8,54 +9,17 @@
 #include <filesystem>
 #include <numeric>
 
-#define _USE_MATH_DEFINES
-#include <math.h>
-
 using namespace cv;
 using namespace std;
 using namespace std::chrono;
 namespace fs = std::filesystem;
 
-struct ContourMetrics {
-    double area_original;
-    double area_hull;
-    double area_ratio;
-    double circularity_original;
-    double circularity_hull;
-    double circularity_ratio;
+struct CannyResult {
+    ContourMetrics metrics;
     vector<Point> contour;
     vector<Point> hull;
 };
 
-ContourMetrics calculate_contour_metrics(const vector<vector<Point>>& contours) {
-    ContourMetrics results;
-    if (contours.empty()) {
-        return results;
-    }
-
-    auto cnt = *max_element(contours.begin(), contours.end(),
-        [](const vector<Point>& c1, const vector<Point>& c2) {
-            return contourArea(c1) < contourArea(c2);
-        });
-
-    results.area_original = contourArea(cnt);
-    double perimeter_original = arcLength(cnt, true);
-    results.circularity_original = (2 * sqrt(M_PI * results.area_original)) / perimeter_original;
-
-    convexHull(cnt, results.hull);
-
-    results.area_hull = contourArea(results.hull);
-    double perimeter_hull = arcLength(results.hull, true);
-    results.circularity_hull = (2 * sqrt(M_PI * results.area_hull)) / perimeter_hull;
-
-    results.area_ratio = results.area_hull / results.area_original;
-    results.circularity_ratio = results.circularity_hull / results.circularity_original;
-
-    results.contour = cnt;
-
-    return results;
-}
-
 bool is_contour_complete(const vector<Point>& contour, const Size& image_size) {
     for (const Point& point : contour) {
         if (point.x <= 0 || point.y <= 0 || point.x >= image_size.width - 1 || point.y >= image_size.height - 1) {
@@ -65,44 +29,36 @@ bool is_contour_complete(const vector<Point>& contour, const Size& image_size) {
     return true;
 }
 
-ContourMetrics process_image(const Mat& img, const Mat& background, bool use_canny) {
-    Mat blur_img, blur_background;
-    GaussianBlur(img, blur_img, Size(3, 3), 0);
-    GaussianBlur(background, blur_background, Size(3, 3), 0);
-
-    Mat substract;
-    subtract(blur_background, blur_img, substract);
-
-    Mat binary;
-    threshold(substract, binary, 10, 255, THRESH_BINARY);
-
-    Mat kernel = getStructuringElement(MORPH_CROSS, Size(3, 3));
-
-    Mat erode1, dilate1, dilate2, erode2;
-    erode(binary, erode1, kernel);
-    dilate(erode1, dilate1, kernel);
-    dilate(dilate1, dilate2, kernel);
-    erode(dilate2, erode2, kernel);
-
-    Mat edge;
-    if (use_canny) {
-        Canny(erode2, edge, 50, 150);
-    } else {
-        edge = erode2;
-    }
-
-    vector<vector<Point>> contours;
-    vector<Vec4i> hierarchy;
-    findContours(edge, contours, hierarchy, RETR_EXTERNAL, CHAIN_APPROX_NONE);
+PipelineConfig canny_config(bool use_canny) {
+    PipelineConfig config;
+    config.blur_size = 3;
+    config.filter_white_pixels = false;
+    config.morphology = {
+        {MorphOp::Erode, 1},
+        {MorphOp::Dilate, 1},
+        {MorphOp::Dilate, 1},
+        {MorphOp::Erode, 1}
+    };
+    config.use_canny = use_canny;
+    config.retrieval_mode = RETR_EXTERNAL;
+    config.circularity = CircularityFormula::SqrtIsoperimetric;
+    return config;
+}
 
-    if (contours.empty() || contours.size() > 1 || !is_contour_complete(contours[0], img.size())) {
-        return ContourMetrics();
+CannyResult process_image(const Mat& img, const CellPipeline& pipeline) {
+    FrameResult frame = pipeline.process(img);
+    if (frame.contours.empty() || frame.contours.size() > 1 || !is_contour_complete(frame.contours[0], img.size())) {
+        return CannyResult();
     }
 
-    return calculate_contour_metrics(contours);
+    CannyResult results;
+    results.metrics = frame.metrics;
+    results.contour = frame.contours[0];
+    convexHull(results.contour, results.hull);
+    return results;
 }
 
-void process_and_compare(const string& img_path, const Mat& background) {
+void process_and_compare(const string& img_path, const CellPipeline& with_canny, const CellPipeline& without_canny) {
     Mat img = imread(img_path, IMREAD_GRAYSCALE);
     if (img.empty()) {
         cout << "Error: Unable to read image: " << img_path << endl;
@@ -110,7 +66,7 @@ void process_and_compare(const string& img_path, const Mat& background) {
     }
 
     auto start_time_with_canny = high_resolution_clock::now();
-    ContourMetrics results_with_canny = process_image(img, background, true);
+    CannyResult results_with_canny = process_image(img, with_canny);
     auto end_time_with_canny = high_resolution_clock::now();
 
     if (results_with_canny.contour.empty()) {
@@ -119,7 +75,7 @@ void process_and_compare(const string& img_path, const Mat& background) {
     }
 
     auto start_time_without_canny = high_resolution_clock::now();
-    ContourMetrics results_without_canny = process_image(img, background, false);
+    CannyResult results_without_canny = process_image(img, without_canny);
     auto end_time_without_canny = high_resolution_clock::now();
 
     if (results_without_canny.contour.empty()) {
@@ -134,12 +90,12 @@ void process_and_compare(const string& img_path, const Mat& background) {
     cout << fixed << setprecision(6);
     cout << "With Canny processing time: " << process_time_with_canny << " seconds" << endl;
     cout << "Without Canny processing time: " << process_time_without_canny << " seconds" << endl;
-    cout << "With Canny area: " << results_with_canny.area_original << " | Without Canny area: " << results_without_canny.area_original << endl;
-    cout << "With Canny Convex Hull area: " << results_with_canny.area_hull << " | Without Canny Convex Hull area: " << results_without_canny.area_hull << endl;
-    cout << "With Canny Area ratio: " << results_with_canny.area_ratio << " | Without Canny Area ratio: " << results_without_canny.area_ratio << endl;
-    cout << "With Canny circularity: " << results_with_canny.circularity_original << " | Without Canny circularity: " << results_without_canny.circularity_original << endl;
-    cout << "With Canny Convex Hull circularity: " << results_with_canny.circularity_hull << " | Without Canny Convex Hull circularity: " << results_without_canny.circularity_hull << endl;
-    cout << "With Canny Circularity ratio: " << results_with_canny.circularity_ratio << " | Without Canny Circularity ratio: " << results_without_canny.circularity_ratio << endl;
+    cout << "With Canny area: " << results_with_canny.metrics.area_original << " | Without Canny area: " << results_without_canny.metrics.area_original << endl;
+    cout << "With Canny Convex Hull area: " << results_with_canny.metrics.area_hull << " | Without Canny Convex Hull area: " << results_without_canny.metrics.area_hull << endl;
+    cout << "With Canny Area ratio: " << results_with_canny.metrics.area_ratio << " | Without Canny Area ratio: " << results_without_canny.metrics.area_ratio << endl;
+    cout << "With Canny circularity: " << results_with_canny.metrics.circularity_original << " | Without Canny circularity: " << results_without_canny.metrics.circularity_original << endl;
+    cout << "With Canny Convex Hull circularity: " << results_with_canny.metrics.circularity_hull << " | Without Canny Convex Hull circularity: " << results_without_canny.metrics.circularity_hull << endl;
+    cout << "With Canny Circularity ratio: " << results_with_canny.metrics.circularity_ratio << " | Without Canny Circularity ratio: " << results_without_canny.metrics.circularity_ratio << endl;
     cout << endl;
 
     // 繪製輪廓
@@ -168,8 +124,9 @@ int main() {
     string cropped_folder = "Test_images/Cropped/";
     string background_path = cropped_folder + "background.tiff";
 
-    Mat background = imread(background_path, IMREAD_GRAYSCALE);
-    if (background.empty()) {
+    CellPipeline with_canny(canny_config(true));
+    CellPipeline without_canny(canny_config(false));
+    if (!with_canny.load_background(background_path) || !without_canny.load_background(background_path)) {
         cout << "Error: Unable to read background image: " << background_path << endl;
         return -1;
     }
@@ -187,12 +144,12 @@ int main() {
             }
 
             auto start_time_with_canny = high_resolution_clock::now();
-            ContourMetrics results_with_canny = process_image(img, background, true);
+            CannyResult results_with_canny = process_image(img, with_canny);
             auto end_time_with_canny = high_resolution_clock::now();
 
             if (!results_with_canny.contour.empty()) {
                 auto start_time_without_canny = high_resolution_clock::now();
-                ContourMetrics results_without_canny = process_image(img, background, false);
+                CannyResult results_without_canny = process_image(img, without_canny);
                 auto end_time_without_canny = high_resolution_clock::now();
 
                 if (!results_without_canny.contour.empty()) {
@@ -220,7 +177,7 @@ int main() {
     for (const auto& entry : fs::directory_iterator(cropped_folder)) {
         if (entry.path().extension() == ".tiff" && entry.path().filename() != "background.tiff") {
             string img_path = entry.path().string();
-            process_and_compare(img_path, background);
+            process_and_compare(img_path, with_canny, without_canny);
         }
     }
 
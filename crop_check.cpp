@@ -0,0 +1,60 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "frame_workspace.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 確認在流程中裁切原始影像與讀取事先裁切好的 512x96crop 資料集結果相同
+int main() {
+    string source_directory = "Test_images/Slight under focus";
+    string cropped_directory = "Test_images/512x96crop";
+
+    PipelineConfig crop_config;
+    crop_config.crop = SLIGHT_UNDER_FOCUS_CROP;
+    CellPipeline crop_pipeline(crop_config), cropped_pipeline;
+    if (!crop_pipeline.load_background(source_directory + "/background.tiff") ||
+        !cropped_pipeline.load_background(cropped_directory + "/background.tiff")) {
+        cerr << "Error: Could not read background images" << endl;
+        return 1;
+    }
+
+    FrameWorkspace crop_workspace, cropped_workspace;
+    FrameResult crop_result, cropped_result;
+    double crop_time = 0, cropped_time = 0;
+    int images = 0, mismatches = 0;
+    for (const string& path : list_images(source_directory)) {
+        string name = path.substr(path.find_last_of("/\\") + 1);
+        Mat image = imread(path, IMREAD_GRAYSCALE);
+        Mat cropped = imread(cropped_directory + "/" + name, IMREAD_GRAYSCALE);
+        if (image.empty() || cropped.empty()) {
+            continue;
+        }
+
+        auto start = chrono::high_resolution_clock::now();
+        crop_pipeline.process(image, crop_workspace, crop_result);
+        auto middle = chrono::high_resolution_clock::now();
+        cropped_pipeline.process(cropped, cropped_workspace, cropped_result);
+        auto end = chrono::high_resolution_clock::now();
+        crop_time += chrono::duration<double, micro>(middle - start).count();
+        cropped_time += chrono::duration<double, micro>(end - middle).count();
+
+        if (crop_result.processed != cropped_result.processed || crop_result.white_pixel_count != cropped_result.white_pixel_count ||
+            crop_result.contours != cropped_result.contours) {
+            cout << "Mismatch: " << name << " white pixels " << crop_result.white_pixel_count << " vs "
+                 << cropped_result.white_pixel_count << endl;
+            mismatches++;
+        }
+        images++;
+    }
+
+    cout << images << " images, " << mismatches << " mismatched" << endl;
+    cout << "  Cropped in pipeline: " << crop_time / max(1, images) << " microseconds" << endl;
+    cout << "  Pre-cropped dataset: " << cropped_time / max(1, images) << " microseconds" << endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -1,173 +1,69 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "allocation_counter.h"
+#include "frame_store.h"
+#include "stage_timer.h"
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <filesystem>
 #include <cmath>
-#include <tbb/task_arena.h>
-#include <tbb/task_group.h>
-#include <tbb/concurrent_queue.h>
-#include <atomic>
-#include <mutex>
-
-#define _USE_MATH_DEFINES
-#include <math.h>
+#include <cstdlib>
+#include <new>
 
 namespace fs = std::filesystem;
 using namespace cv;
 using namespace std;
 
-struct ContourMetrics {
-    double area_original = 0;
-    double area_hull = 0;
-    double area_ratio = 0;
-    double circularity_original = 0;
-    double circularity_hull = 0;
-    double circularity_ratio = 0;
-};
-
-ContourMetrics calculate_contour_metrics(const vector<vector<Point>>& contours) {
-    if (contours.empty()) {
-        return ContourMetrics();
-    }
-
-    auto cnt = *max_element(contours.begin(), contours.end(),
-                            [](const auto& c1, const auto& c2) { return contourArea(c1) < contourArea(c2); });
-
-    double area_original = contourArea(cnt);
-    double perimeter_original = arcLength(cnt, true);
-
-    if (area_original <= 1e-6 || perimeter_original <= 1e-6) {
-        return ContourMetrics();
+// 替換全域 operator new 以計算每個執行緒的配置次數
+void* operator new(size_t size) {
+    count_allocation();
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
     }
-
-    double circularity_original = 4 * M_PI * area_original / (perimeter_original * perimeter_original);
-
-    vector<Point> hull;
-    convexHull(cnt, hull);
-
-    double area_hull = contourArea(hull);
-    double perimeter_hull = arcLength(hull, true);
-
-    if (area_hull <= 1e-6 || perimeter_hull <= 1e-6) {
-        return ContourMetrics();
-    }
-
-    double circularity_hull = 4 * M_PI * area_hull / (perimeter_hull * perimeter_hull);
-
-    ContourMetrics results;
-    results.area_original = area_original;
-    results.area_hull = area_hull;
-    results.area_ratio = area_hull / area_original;
-    results.circularity_original = circularity_original;
-    results.circularity_hull = circularity_hull;
-    results.circularity_ratio = circularity_hull / circularity_original;
-
-    return results;
+    throw bad_alloc();
 }
 
-void process_single_image(const string& image_path, const Mat& blurred_bg, vector<vector<Point>>& contours, ContourMetrics& metrics, double& duration, double& findcontour_duration) {
-    Mat image = imread(image_path, IMREAD_GRAYSCALE);
-    auto start_time = chrono::high_resolution_clock::now();
-
-    Mat blurred;
-    GaussianBlur(image, blurred, Size(5, 5), 0);
-    Mat bg_sub;
-    subtract(blurred_bg, blurred, bg_sub);
-    Mat binary;
-    threshold(bg_sub, binary, 10, 255, THRESH_BINARY);
-
-    int white_pixel_count = countNonZero(binary);
-    
-    if (white_pixel_count < 250 || white_pixel_count > 650) {
-        duration = 0;
-        return;
-    }
-
-    Mat kernel = getStructuringElement(MORPH_CROSS, Size(3, 3));
-    Mat dilate1, erode1, dilate2;
-    dilate(binary, dilate1, kernel, Point(-1, -1), 2);
-    erode(dilate1, erode1, kernel, Point(-1, -1), 3);
-    dilate(erode1, dilate2, kernel, Point(-1, -1), 1);
-
-    vector<Vec4i> hierarchy;
-    auto findcontour_start = chrono::high_resolution_clock::now();
-
-    findContours(dilate2, contours, hierarchy, RETR_LIST, CHAIN_APPROX_NONE);
-
-    auto findcontour_end = chrono::high_resolution_clock::now();
-    findcontour_duration = chrono::duration<double, micro>(findcontour_end - findcontour_start).count();
+void operator delete(void* p) noexcept {
+    free(p);
+}
 
-    auto end_time = chrono::high_resolution_clock::now();
-    duration = chrono::duration<double, micro>(end_time - start_time).count();
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
 
-    if (!contours.empty()) {
-        metrics = calculate_contour_metrics(contours);
+void collect_results(const vector<string>& image_paths, const vector<FrameResult>& frames, vector<tuple<string, double, double, double, double>>& results, vector<string>& skipped_images, pair<string, double>& max_time_image) {
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const FrameResult& frame = frames[i];
+        if (frame.processed) {
+            if (frame.duration > max_time_image.second) {
+                max_time_image = { image_paths[i], frame.duration };
+            }
+            results.push_back(make_tuple(image_paths[i], frame.metrics.circularity_ratio, frame.metrics.area_ratio, frame.duration, frame.findcontour_duration));
+        } else {
+            skipped_images.push_back(image_paths[i]);
+        }
     }
 }
 
-void run_experiment(string directory, vector<tuple<string, double, double, double, double>>& results, vector<string>& skipped_images, pair<string, double>& max_time_image) {
+void run_experiment(string directory, const PipelineConfig& config, int num_threads, WorkspacePool& workspaces, vector<FrameResult>& frames, vector<tuple<string, double, double, double, double>>& results, vector<string>& skipped_images, pair<string, double>& max_time_image, RunStats& stats) {
     string background_path = directory + "/background.tiff";
-    Mat background = imread(background_path, IMREAD_GRAYSCALE);
-    if (background.empty()) {
+    CellPipeline pipeline(config);
+    if (!pipeline.load_background(background_path)) {
         cerr << "Error: Could not read background image: " << background_path << endl;
         return;
     }
-    Mat blurred_bg;
-    GaussianBlur(background, blurred_bg, Size(5, 5), 0);
-
-    atomic<double> total_time(0);
-    atomic<double> total_findcontour_time(0);
-    atomic<int> number(0);
-    atomic<double> max_process_time(0);
-    mutex mtx;
-
-    tbb::task_arena arena(thread::hardware_concurrency());
-    tbb::task_group group;
-    tbb::concurrent_queue<fs::path> image_queue;
-
-    atomic<bool> processing_complete(false);
-
-    arena.execute([&]() {
-        group.run([&]() {
-            while (!processing_complete || !image_queue.empty()) {
-                fs::path path;
-                if (image_queue.try_pop(path)) {
-                    vector<vector<Point>> contours;
-                    ContourMetrics metrics;
-                    double process_time;
-                    double findcontour_time;
-                    process_single_image(path.string(), blurred_bg, contours, metrics, process_time, findcontour_time);
-
-                    if (process_time > 0) {
-                        lock_guard<mutex> lock(mtx);
-                        total_time = total_time + process_time;
-                        total_findcontour_time = total_findcontour_time + findcontour_time;
-                        if (process_time > max_process_time) {
-                            max_process_time = process_time;
-                            max_time_image = { path.string(), process_time };
-                        }
-                        number++;
-                        results.push_back(make_tuple(path.string(), metrics.circularity_ratio, metrics.area_ratio, process_time, findcontour_time));
-                    } else {
-                        lock_guard<mutex> lock(mtx);
-                        skipped_images.push_back(path.string());
-                    }
-                } else {
-                    this_thread::yield();
-                }
-            }
-        });
-    });
 
-    for (const auto& entry : fs::directory_iterator(directory)) {
-        if (entry.path().extension() == ".tiff" && entry.path().filename() != "background.tiff") {
-            image_queue.push(entry.path());
-        }
-    }
+    vector<string> image_paths = list_images(directory);
+    stats = run_parallel(pipeline, image_paths, frames, workspaces, num_threads);
+    collect_results(image_paths, frames, results, skipped_images, max_time_image);
+}
 
-    processing_complete = true;
-    group.wait();
+// 預先解碼的模式：背景與影像只讀取一次，每次重複只執行處理本身
+void run_preloaded(const CellPipeline& pipeline, const FrameStore& store, int num_threads, WorkspacePool& workspaces, vector<FrameResult>& frames, vector<tuple<string, double, double, double, double>>& results, vector<string>& skipped_images, pair<string, double>& max_time_image, RunStats& stats) {
+    stats = run_parallel(pipeline, store, frames, workspaces, num_threads);
+    collect_results(store.paths(), frames, results, skipped_images, max_time_image);
 }
 
 void print_progress(int current, int total) {
@@ -184,24 +80,62 @@ void print_progress(int current, int total) {
     cout.flush();
 }
 
-int main() {
-    string directory = "Test_images/512x96crop";
+int main(int argc, char** argv) {
+    // 可指定線程數量，預設使用全部硬體線程；第二個參數為 --from-disk 時每次重複都重新讀檔
+    int num_threads = argc > 1 ? atoi(argv[1]) : 0;
+    bool from_disk = argc > 2 && string(argv[2]) == "--from-disk";
+    // 直接讀取原始影像，在流程中裁切 (取代 512x96crop 資料集)
+    string directory = "Test_images/Slight under focus";
+    PipelineConfig config;
+    config.crop = SLIGHT_UNDER_FOCUS_CROP;
+
+    CellPipeline pipeline(config);
+    FrameStore store;
+    if (!from_disk) {
+        auto load_start = chrono::steady_clock::now();
+        if (!pipeline.load_background(directory + "/background.tiff") || !store.load_directory(directory)) {
+            cerr << "Error: Could not preload images in " << directory << endl;
+            return 1;
+        }
+        double load_time = chrono::duration<double>(chrono::steady_clock::now() - load_start).count();
+        cout << "Preloaded " << store.size() << " frames (" << store.bytes() / 1024 << " KB) in " << load_time << " s" << endl;
+    }
     vector<tuple<string, double, double, double, double>> results;
     vector<string> skipped_images;
     pair<string, double> max_time_image;
+    RunStats stats;
+
+    // workspace 與結果緩衝區跨重複保留，第一輪之後即為穩定狀態
+    install_allocation_counter();
+    WorkspacePool workspaces;
+    vector<FrameResult> frames;
+    size_t warmup_allocations = 0;
+    size_t steady_allocations = 0;
 
     const int repetitions = 10000;
     double total_circularity_ratio = 0;
     double total_area_ratio = 0;
     double total_processing_time = 0;
     double total_findcontour_time = 0;
+    size_t total_frames = 0;
+    double total_wall_time = 0;
+    StageLatencies latency;
 
     for (int i = 0; i < repetitions; ++i) {
         results.clear();
         skipped_images.clear();
         max_time_image = {"", 0};
 
-        run_experiment(directory, results, skipped_images, max_time_image);
+        if (from_disk) {
+            run_experiment(directory, config, num_threads, workspaces, frames, results, skipped_images, max_time_image, stats);
+        } else {
+            run_preloaded(pipeline, store, num_threads, workspaces, frames, results, skipped_images, max_time_image, stats);
+        }
+        if (i == 0) {
+            warmup_allocations = stats.allocations;
+        } else {
+            steady_allocations += stats.allocations;
+        }
 
         for (const auto& result : results) {
             total_circularity_ratio += get<1>(result);
@@ -209,6 +143,9 @@ int main() {
             total_processing_time += get<3>(result);
             total_findcontour_time += get<4>(result);
         }
+        total_frames += stats.frames;
+        total_wall_time += stats.wall_time;
+        latency.merge(stats.latency);
 
         print_progress(i + 1, repetitions);
     }
@@ -225,6 +162,16 @@ int main() {
     cout << "Average Area Ratio: " << average_area_ratio << endl;
     cout << "Average Processing Time: " << average_processing_time << " microseconds" << endl;
     cout << "Average FindContours Time: " << average_findcontour_time << " microseconds" << endl;
+    cout << "Threads: " << stats.threads << ", throughput: " << (total_wall_time > 0 ? total_frames / total_wall_time : 0) << " frames/sec" << endl;
+    cout << "Heap allocations while processing: " << warmup_allocations << " in the first repetition, "
+         << steady_allocations << " in the remaining " << repetitions - 1 << endl;
+
+    latency.print(cout);
+    print_stage_timers(cout);
+    const string latency_path = "findcontour_time_10000_latency.csv";
+    if (latency.dump_csv(latency_path)) {
+        cout << "Latency histogram written to " << latency_path << endl;
+    }
 
     return 0;
 }
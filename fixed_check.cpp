@@ -0,0 +1,92 @@
+#include "cell_pipeline.h"
+#include "fixed_geometry.h"
+#include "frame_runner.h"
+#include "frame_workspace.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 檢查固定大小特化的形態學與通用 bit-packed 引擎的結果是否相同，並比較耗時。
+// 沒有特化版本的影像大小兩邊都走通用路徑；最後一行只統計有特化版本的影像，即特化帶來的加速
+int main() {
+    vector<string> directories = {"Test_images/512x96crop", "Test_images/Cropped", "Test_images/In focus"};
+    const int repetitions = 100;
+
+    PipelineConfig generic_config;
+    generic_config.use_fixed_geometry = false;
+    PipelineConfig fixed_config;
+
+    int total_mismatch_images = 0;
+    double specialised_generic_time = 0, specialised_fixed_time = 0;
+    int specialised_runs = 0;
+    for (const string& directory : directories) {
+        CellPipeline generic_pipeline(generic_config);
+        CellPipeline fixed_pipeline(fixed_config);
+        string background_path = directory + "/background.tiff";
+        if (!generic_pipeline.load_background(background_path) || !fixed_pipeline.load_background(background_path)) {
+            cerr << "Error: Could not read background image: " << background_path << endl;
+            continue;
+        }
+
+        FrameWorkspace generic_workspace, fixed_workspace;
+        double generic_time = 0, fixed_time = 0;
+        int mismatch_images = 0, images = 0, specialised = 0;
+        for (const string& path : list_images(directory)) {
+            Mat image = imread(path, IMREAD_GRAYSCALE);
+            if (image.empty()) {
+                continue;
+            }
+            Mat binary;
+            generic_pipeline.segment(image, binary);
+            bool has_fixed = find_fixed_kernels(binary.size()) != nullptr;
+            specialised += has_fixed;
+
+            Mat expected, actual;
+            auto start = chrono::high_resolution_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                generic_pipeline.morphology(binary, expected, generic_workspace);
+            }
+            auto middle = chrono::high_resolution_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                fixed_pipeline.morphology(binary, actual, fixed_workspace);
+            }
+            auto end = chrono::high_resolution_clock::now();
+            double generic_us = chrono::duration<double, micro>(middle - start).count();
+            double fixed_us = chrono::duration<double, micro>(end - middle).count();
+            generic_time += generic_us;
+            fixed_time += fixed_us;
+            if (has_fixed) {
+                specialised_generic_time += generic_us;
+                specialised_fixed_time += fixed_us;
+                specialised_runs += repetitions;
+            }
+
+            int diff = countNonZero(expected != actual);
+            if (diff > 0) {
+                cout << "Mismatch: " << path << " (" << diff << " pixels)" << endl;
+                mismatch_images++;
+            }
+            images++;
+        }
+
+        int runs = max(1, images * repetitions);
+        cout << directory << ": " << images << " images (" << specialised << " with fixed kernels), "
+             << mismatch_images << " mismatched" << endl;
+        cout << "  Generic bit-packed engine: " << generic_time / runs << " microseconds" << endl;
+        cout << "  Fixed geometry:            " << fixed_time / runs << " microseconds" << endl;
+        total_mismatch_images += mismatch_images;
+    }
+
+    if (specialised_runs > 0) {
+        cout << "Images with fixed kernels: generic " << specialised_generic_time / specialised_runs << " microseconds, fixed "
+             << specialised_fixed_time / specialised_runs << " microseconds ("
+             << 100.0 * (1 - specialised_fixed_time / specialised_generic_time) << " % faster)" << endl;
+    }
+
+    return total_mismatch_images == 0 ? 0 : 1;
+}
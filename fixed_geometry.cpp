@@ -0,0 +1,154 @@
+#include "fixed_geometry.h"
+#include "binary_morphology.h"
+#include "fused_threshold.h"
+#include "stage_timer.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FIXED_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#define FIXED_INLINE __forceinline
+#else
+#define FIXED_INLINE inline __attribute__((always_inline))
+#if defined(FIXED_SSE2)
+// 形態學的模板另外以 AVX2 編譯一次，由 find_fixed_kernels 依 CPU 選擇
+#define FIXED_AVX2 1
+#endif
+#endif
+
+using namespace cv;
+using namespace std;
+
+template <int Width, int Height>
+struct Geometry {
+    static_assert(Width >= 3 && Height >= 3, "fixed geometry needs at least 3x3 frames");
+    static constexpr int words = (Width + 63) / 64;
+    static constexpr uint64_t last_mask = Width % 64 == 0 ? ~0ull : (1ull << (Width % 64)) - 1;
+};
+
+template <int Width, int Height>
+struct FixedBits {
+    uint64_t rows[Height][Geometry<Width, Height>::words];
+};
+
+template <int Width, int Height>
+static FIXED_INLINE void pack_impl(const uchar* src, size_t src_step, FixedBits<Width, Height>& bits) {
+    const int words = Geometry<Width, Height>::words;
+    for (int y = 0; y < Height; ++y) {
+        const uchar* row = src + y * src_step;
+        uint64_t* out = bits.rows[y];
+        for (int k = 0; k < words; ++k) {
+            out[k] = 0;
+        }
+
+        int x = 0;
+#ifdef FIXED_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= Width; x += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            uint64_t mask = static_cast<uint16_t>(~_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+            out[x >> 6] |= mask << (x & 63);
+        }
+#endif
+        for (; x < Width; ++x) {
+            out[x >> 6] |= static_cast<uint64_t>(row[x] != 0) << (x & 63);
+        }
+    }
+}
+
+// 與 BitMask::step 相同的 bit_cross_row，每列 word 數與遮罩為編譯期常數
+template <int Width, int Height, bool Dilate>
+static FIXED_INLINE void step_impl(const FixedBits<Width, Height>& in, FixedBits<Width, Height>& out) {
+    const int words = Geometry<Width, Height>::words;
+    const uint64_t last_mask = Geometry<Width, Height>::last_mask;
+    for (int y = 0; y < Height; ++y) {
+        const uint64_t* up = y > 0 ? in.rows[y - 1] : nullptr;
+        const uint64_t* down = y < Height - 1 ? in.rows[y + 1] : nullptr;
+        bit_cross_row<Dilate>(in.rows[y], up, down, out.rows[y], words, last_mask);
+    }
+}
+
+template <int Width, int Height>
+static FIXED_INLINE void unpack_impl(const FixedBits<Width, Height>& bits, uchar* dst, size_t dst_step) {
+    for (int y = 0; y < Height; ++y) {
+        const uint64_t* row = bits.rows[y];
+        uchar* out = dst + y * dst_step;
+        for (int x = 0; x < Width; ++x) {
+            out[x] = static_cast<uchar>(0 - ((row[x >> 6] >> (x & 63)) & 1));
+        }
+    }
+}
+
+template <int Width, int Height>
+static FIXED_INLINE bool morphology_impl(const uchar* src, size_t src_step, uchar* dst, size_t dst_step,
+                                         const MorphStep* steps, size_t step_count, uint64_t deadline_cycles) {
+    FixedBits<Width, Height> buffers[2];
+    int current = 0;
+    {
+        STAGE_TIMER(MorphPack);
+        pack_impl<Width, Height>(src, src_step, buffers[0]);
+    }
+    for (size_t i = 0; i < step_count; ++i) {
+        if (steps[i].op == MorphOp::Dilate) {
+            STAGE_TIMER(Dilate);
+            for (int n = 0; n < steps[i].iterations; ++n) {
+                step_impl<Width, Height, true>(buffers[current], buffers[current ^ 1]);
+                current ^= 1;
+            }
+        } else {
+            STAGE_TIMER(Erode);
+            for (int n = 0; n < steps[i].iterations; ++n) {
+                step_impl<Width, Height, false>(buffers[current], buffers[current ^ 1]);
+                current ^= 1;
+            }
+        }
+        if (deadline_cycles && read_cycles() > deadline_cycles) {
+            return false;
+        }
+    }
+    STAGE_TIMER(MorphUnpack);
+    unpack_impl<Width, Height>(buffers[current], dst, dst_step);
+    return true;
+}
+
+// 每個影像大小與指令集各實例化一次 morphology_impl，大小只列在 FIXED_GEOMETRY_SIZES
+#define FIXED_GEOMETRY_SIZES(X) \
+    X(512, 96)                  \
+    X(992, 200)
+
+#define FIXED_MORPHOLOGY_TARGET(name, attributes)                                                             \
+    template <int Width, int Height>                                                                          \
+    attributes static bool name(const uchar* src, size_t src_step, uchar* dst, size_t dst_step,              \
+                                const MorphStep* steps, size_t step_count, uint64_t deadline_cycles) {       \
+        return morphology_impl<Width, Height>(src, src_step, dst, dst_step, steps, step_count, deadline_cycles); \
+    }
+
+#define FIXED_KERNEL_ENTRY(name, width, height) {width, height, name<width, height>},
+
+FIXED_MORPHOLOGY_TARGET(morphology_baseline, )
+#define FIXED_BASELINE_ENTRY(width, height) FIXED_KERNEL_ENTRY(morphology_baseline, width, height)
+static const FixedGeometryKernels baseline_kernels[] = {FIXED_GEOMETRY_SIZES(FIXED_BASELINE_ENTRY)};
+
+#ifdef FIXED_AVX2
+FIXED_MORPHOLOGY_TARGET(morphology_avx2, __attribute__((target("avx2"))))
+#define FIXED_AVX2_ENTRY(width, height) FIXED_KERNEL_ENTRY(morphology_avx2, width, height)
+static const FixedGeometryKernels avx2_kernels[] = {FIXED_GEOMETRY_SIZES(FIXED_AVX2_ENTRY)};
+#endif
+
+const FixedGeometryKernels* find_fixed_kernels(Size size) {
+    const FixedGeometryKernels* kernels = baseline_kernels;
+#ifdef FIXED_AVX2
+    static const bool avx2 = simd_level_supported(SimdLevel::AVX2);
+    if (avx2) {
+        kernels = avx2_kernels;
+    }
+#endif
+    for (size_t i = 0; i < sizeof(baseline_kernels) / sizeof(baseline_kernels[0]); ++i) {
+        if (kernels[i].width == size.width && kernels[i].height == size.height) {
+            return &kernels[i];
+        }
+    }
+    return nullptr;
+}
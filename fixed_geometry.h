@@ -0,0 +1,22 @@
+#pragma once
+
+#include "cell_pipeline.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// 資料集的影像大小固定 (512x96 裁切、992x200 In focus)，形態學核心也固定為 3x3 MORPH_CROSS。
+// 以寬高為模板參數實例化 bit-packed 形態學，迴圈次數、每列 word 數與邊界遮罩都在編譯期決定，
+// 讓編譯器完全展開並向量化。結果與 binary_morphology.h 的通用版本逐位元相同。
+struct FixedGeometryKernels {
+    int width;
+    int height;
+
+    // 與 BitMask::pack -> 依序 dilate / erode -> unpack 相同。
+    // deadline_cycles 不為 0 時每一步之後檢查 read_cycles()，超過回傳 false
+    bool (*morphology)(const unsigned char* src, size_t src_step, unsigned char* dst, size_t dst_step,
+                       const MorphStep* steps, size_t step_count, uint64_t deadline_cycles);
+};
+
+// size 有特化版本時回傳該版本的核心 (依 CPU 選擇指令集)，否則回傳 nullptr 使用通用路徑
+const FixedGeometryKernels* find_fixed_kernels(cv::Size size);
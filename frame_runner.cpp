@@ -0,0 +1,257 @@
+#include "frame_runner.h"
+#include "allocation_counter.h"
+#include "frame_source.h"
+#include "frame_stack.h"
+#include "frame_store.h"
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_pipeline.h>
+#include <tbb/task_arena.h>
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+
+vector<string> list_images(const string& directory) {
+    vector<string> paths;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() == ".tiff" && entry.path().filename() != "background.tiff") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    // directory_iterator 的順序依檔案系統而定，排序後所有工具都以檔名 (取像) 順序處理
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// get_frame(i) 回傳第 i 張影像 (讀檔或記憶體中的 header)，計入配置次數的只有 process 本身
+template <typename GetFrame>
+static RunStats run_frames(const CellPipeline& pipeline, size_t frame_count, GetFrame get_frame,
+                           vector<FrameResult>& results, WorkspacePool& workspaces, int num_threads) {
+    RunStats stats;
+    stats.threads = num_threads > 0 ? num_threads : static_cast<int>(thread::hardware_concurrency());
+    stats.frames = frame_count;
+
+    // 不清空 results，process 會重設每個欄位並沿用原本的輪廓緩衝區
+    results.resize(frame_count);
+    atomic<size_t> allocations(0);
+    tbb::enumerable_thread_specific<StageLatencies> latencies;
+
+    tbb::task_arena arena(stats.threads);
+    auto start_time = chrono::steady_clock::now();
+
+    // 每張影像是一個獨立工作，結果寫入各自的位置，不需要鎖
+    arena.execute([&]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, frame_count, 1),
+                          [&](const tbb::blocked_range<size_t>& range) {
+                              FrameWorkspace& workspace = workspaces.local();
+                              StageLatencies& latency = latencies.local();
+                              for (size_t i = range.begin(); i != range.end(); ++i) {
+                                  Mat image = get_frame(i);
+                                  size_t before = thread_allocation_count();
+                                  pipeline.process(image, workspace, results[i]);
+                                  allocations += thread_allocation_count() - before;
+                                  latency.record(results[i]);
+                              }
+                          });
+    });
+
+    auto end_time = chrono::steady_clock::now();
+    stats.wall_time = chrono::duration<double>(end_time - start_time).count();
+    stats.frames_per_second = stats.wall_time > 0 ? stats.frames / stats.wall_time : 0;
+    stats.allocations = allocations;
+    latencies.combine_each([&](const StageLatencies& latency) { stats.latency.merge(latency); });
+    return stats;
+}
+
+RunStats run_parallel(const CellPipeline& pipeline, const vector<string>& image_paths,
+                      vector<FrameResult>& results, int num_threads) {
+    WorkspacePool workspaces;
+    results.clear();
+    return run_parallel(pipeline, image_paths, results, workspaces, num_threads);
+}
+
+RunStats run_parallel(const CellPipeline& pipeline, const vector<string>& image_paths,
+                      vector<FrameResult>& results, WorkspacePool& workspaces, int num_threads) {
+    return run_frames(pipeline, image_paths.size(),
+                      [&](size_t i) { return imread(image_paths[i], IMREAD_GRAYSCALE); },
+                      results, workspaces, num_threads);
+}
+
+RunStats run_parallel(const CellPipeline& pipeline, const FrameStore& frames,
+                      vector<FrameResult>& results, WorkspacePool& workspaces, int num_threads) {
+    return run_frames(pipeline, frames.size(), [&](size_t i) { return frames.frame(i); },
+                      results, workspaces, num_threads);
+}
+
+RunStats run_parallel(const CellPipeline& pipeline, const FrameStackReader& frames,
+                      vector<FrameResult>& results, WorkspacePool& workspaces, int num_threads) {
+    return run_frames(pipeline, frames.size(), [&](size_t i) { return frames.frame(i); },
+                      results, workspaces, num_threads);
+}
+
+// 處理中的影像的狀態與 workspace，在 run_pipelined 中重複使用
+struct TokenSlot {
+    FrameState state;
+    FrameWorkspace workspace;
+};
+
+// pipeline 中每個 token 攜帶的資料，影像狀態放在 slots[slot]
+struct FrameToken {
+    size_t index = 0;
+    uint32_t slot = 0;
+    bool active = true;
+};
+
+RunStats run_pipelined(const CellPipeline& pipeline, const vector<string>& image_paths,
+                       vector<FrameResult>& results, int max_tokens, int num_threads) {
+    RunStats stats;
+    stats.threads = num_threads > 0 ? num_threads : static_cast<int>(thread::hardware_concurrency());
+    stats.frames = image_paths.size();
+    if (max_tokens <= 0) {
+        max_tokens = 2 * stats.threads;
+    }
+
+    results.clear();
+    results.resize(image_paths.size());
+    atomic<size_t> allocations(0);
+    tbb::enumerable_thread_specific<StageLatencies> latencies;
+
+    // 同一張影像的各階段可能在不同執行緒上執行，且 mask 指向 preprocess 所用的 workspace，
+    // 因此 workspace 跟著 token 走而不是跟著執行緒。同時最多 max_tokens 個 token，
+    // 取影像階段從 free_slots 取一個 slot，最後一個階段歸還。
+    // 影像不一定依序完成，所以不能用 index % max_tokens 選 slot
+    vector<TokenSlot> slots(max_tokens);
+    for (TokenSlot& slot : slots) {
+        slot.state.workspace = &slot.workspace;
+    }
+    MpmcRing<uint32_t> free_slots(max_tokens);
+    for (int i = 0; i < max_tokens; ++i) {
+        free_slots.try_push(static_cast<uint32_t>(i));
+    }
+
+    tbb::task_arena arena(stats.threads);
+    auto start_time = chrono::steady_clock::now();
+
+    arena.execute([&]() {
+        size_t next = 0;
+        tbb::parallel_pipeline(
+            static_cast<size_t>(max_tokens),
+            tbb::make_filter<void, FrameToken>(tbb::filter_mode::serial_in_order,
+                [&](tbb::flow_control& fc) {
+                    FrameToken token;
+                    if (next >= image_paths.size()) {
+                        fc.stop();
+                        return token;
+                    }
+                    token.index = next++;
+                    free_slots.try_pop(token.slot);
+                    slots[token.slot].state.reset();
+                    return token;
+                }) &
+            tbb::make_filter<FrameToken, FrameToken>(tbb::filter_mode::parallel,
+                [&](FrameToken token) {
+                    token.active = pipeline.decode(image_paths[token.index], slots[token.slot].state);
+                    return token;
+                }) &
+            tbb::make_filter<FrameToken, FrameToken>(tbb::filter_mode::parallel,
+                [&](FrameToken token) {
+                    size_t before = thread_allocation_count();
+                    token.active = token.active && pipeline.preprocess(slots[token.slot].state);
+                    allocations += thread_allocation_count() - before;
+                    return token;
+                }) &
+            tbb::make_filter<FrameToken, FrameToken>(tbb::filter_mode::parallel,
+                [&](FrameToken token) {
+                    size_t before = thread_allocation_count();
+                    token.active = token.active && pipeline.extract_contours(slots[token.slot].state);
+                    allocations += thread_allocation_count() - before;
+                    return token;
+                }) &
+            tbb::make_filter<FrameToken, void>(tbb::filter_mode::parallel,
+                [&](FrameToken token) {
+                    FrameState& state = slots[token.slot].state;
+                    size_t before = thread_allocation_count();
+                    if (token.active) {
+                        pipeline.compute_metrics(state);
+                    }
+                    allocations += thread_allocation_count() - before;
+                    latencies.local().record(state.result);
+                    results[token.index] = std::move(state.result);
+                    free_slots.try_push(token.slot);
+                }));
+    });
+
+    auto end_time = chrono::steady_clock::now();
+    stats.wall_time = chrono::duration<double>(end_time - start_time).count();
+    stats.frames_per_second = stats.wall_time > 0 ? stats.frames / stats.wall_time : 0;
+    stats.allocations = allocations;
+    latencies.combine_each([&](const StageLatencies& latency) { stats.latency.merge(latency); });
+    return stats;
+}
+
+// run_source 中每個 token 攜帶的資料
+struct SourceToken {
+    Frame frame;
+    FrameResult result;
+};
+
+RunStats run_source(const CellPipeline& pipeline, FrameSource& source, vector<FrameResult>& results,
+                    int max_tokens, int num_threads) {
+    RunStats stats;
+    stats.threads = num_threads > 0 ? num_threads : static_cast<int>(thread::hardware_concurrency());
+    if (max_tokens <= 0) {
+        max_tokens = 2 * stats.threads;
+    }
+
+    results.clear();
+    results.reserve(source.size());
+    WorkspacePool workspaces;
+
+    tbb::task_arena arena(stats.threads);
+    auto start_time = chrono::steady_clock::now();
+
+    arena.execute([&]() {
+        tbb::parallel_pipeline(
+            static_cast<size_t>(max_tokens),
+            tbb::make_filter<void, SourceToken>(tbb::filter_mode::serial_in_order,
+                [&](tbb::flow_control& fc) {
+                    SourceToken token;
+                    if (!source.next(token.frame)) {
+                        fc.stop();
+                    }
+                    return token;
+                }) &
+            tbb::make_filter<SourceToken, SourceToken>(tbb::filter_mode::parallel,
+                [&](SourceToken token) {
+                    pipeline.process(token.frame.image, workspaces.local(), token.result);
+                    source.release(token.frame);
+                    return token;
+                }) &
+            tbb::make_filter<SourceToken, void>(tbb::filter_mode::serial_in_order,
+                [&](SourceToken token) {
+                    stats.latency.record(token.result);
+                    results.push_back(std::move(token.result));
+                }));
+    });
+
+    auto end_time = chrono::steady_clock::now();
+    stats.frames = results.size();
+    stats.wall_time = chrono::duration<double>(end_time - start_time).count();
+    stats.frames_per_second = stats.wall_time > 0 ? stats.frames / stats.wall_time : 0;
+    return stats;
+}
+
+void print_run_stats(const RunStats& stats) {
+    cout << "Threads: " << stats.threads << ", frames: " << stats.frames
+         << ", wall time: " << stats.wall_time << " s"
+         << ", throughput: " << stats.frames_per_second << " frames/sec" << endl;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "cell_pipeline.h"
+#include "frame_workspace.h"
+#include "latency_histogram.h"
+#include <string>
+#include <tbb/enumerable_thread_specific.h>
+#include <vector>
+
+struct RunStats {
+    int threads = 0;
+    size_t frames = 0;
+    double wall_time = 0;          // 秒
+    double frames_per_second = 0;
+    size_t allocations = 0;        // 處理階段 (不含讀檔) 的 heap 配置次數，見 allocation_counter.h
+    StageLatencies latency;        // 每張影像各階段的延遲分布
+};
+
+// 每個工作執行緒一個 workspace，跨多次 run_parallel 保留即可在穩定狀態下完全不配置記憶體
+typedef tbb::enumerable_thread_specific<FrameWorkspace> WorkspacePool;
+
+class FrameStore;
+class FrameStackReader;
+class FrameSource;
+
+// 依檔名排序列出資料夾內除 background.tiff 以外的所有 .tiff
+std::vector<std::string> list_images(const std::string& directory);
+
+// 以 tbb::parallel_for 平行處理所有影像，results[i] 對應 image_paths[i]
+// num_threads <= 0 時使用 hardware_concurrency
+RunStats run_parallel(const CellPipeline& pipeline, const std::vector<std::string>& image_paths,
+                      std::vector<FrameResult>& results, int num_threads = 0);
+// 同上，但使用呼叫端的 workspace，且 results 中既有的輪廓緩衝區會被重複使用
+RunStats run_parallel(const CellPipeline& pipeline, const std::vector<std::string>& image_paths,
+                      std::vector<FrameResult>& results, WorkspacePool& workspaces, int num_threads = 0);
+// 處理已預先解碼到記憶體中的影像 (frame_store.h)，results[i] 對應 frames.frame(i)
+RunStats run_parallel(const CellPipeline& pipeline, const FrameStore& frames,
+                      std::vector<FrameResult>& results, WorkspacePool& workspaces, int num_threads = 0);
+// 直接處理 mmap 的 frame stack (frame_stack.h)，影像不經解碼或複製
+RunStats run_parallel(const CellPipeline& pipeline, const FrameStackReader& frames,
+                      std::vector<FrameResult>& results, WorkspacePool& workspaces, int num_threads = 0);
+
+// 以 tbb::parallel_pipeline 分成 讀檔 -> 前處理 -> 輪廓 -> 指標 四個階段，
+// 最多同時有 max_tokens 張影像在處理中，讓 I/O 與計算重疊
+// max_tokens <= 0 時使用 2 * 線程數；每個處理中的 token 各有一個 FrameWorkspace，用完後給下一張影像重用
+RunStats run_pipelined(const CellPipeline& pipeline, const std::vector<std::string>& image_paths,
+                       std::vector<FrameResult>& results, int max_tokens = 0, int num_threads = 0);
+
+// 從 FrameSource (frame_source.h) 持續取影像，直到來源結束：取影像為 serial 階段，
+// 處理為 parallel 階段 (每個執行緒一個 workspace)，結果依取得順序附加到 results
+// max_tokens <= 0 時使用 2 * 線程數
+RunStats run_source(const CellPipeline& pipeline, FrameSource& source, std::vector<FrameResult>& results,
+                    int max_tokens = 0, int num_threads = 0);
+
+void print_run_stats(const RunStats& stats);
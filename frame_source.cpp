@@ -0,0 +1,140 @@
+#include "frame_source.h"
+#include "frame_runner.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace cv;
+using namespace std;
+
+DirectorySource::DirectorySource(const string& directory)
+    : paths_(list_images(directory)), start_(chrono::steady_clock::now()) {}
+
+bool DirectorySource::next(Frame& frame) {
+    if (next_ >= paths_.size()) {
+        return false;
+    }
+    frame.index = next_;
+    frame.image = imread(paths_[next_], IMREAD_GRAYSCALE);
+    frame.timestamp_us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start_).count();
+    next_++;
+    return true;
+}
+
+bool FrameStackSource::next(Frame& frame) {
+    if (next_ >= reader_.size()) {
+        return false;
+    }
+    frame.index = next_;
+    frame.image = reader_.frame(next_);
+    frame.timestamp_us = reader_.timestamp(next_);
+    next_++;
+    return true;
+}
+
+SimulatedCamera::SimulatedCamera(const FrameStore& dataset, const CameraConfig& config)
+    : dataset_(dataset), config_(config), ring_(config.ring_capacity, dataset.frame_size()) {
+    for (size_t i = 0; i < dataset_.size(); ++i) {
+        if (!dataset_.frame(i).empty()) {
+            replay_.push_back(i);
+        }
+    }
+}
+
+SimulatedCamera::~SimulatedCamera() {
+    stop();
+}
+
+void SimulatedCamera::start() {
+    stop();
+    CV_Assert(!finished_ && "SimulatedCamera cannot be restarted");
+    produced_ = 0;
+    dropped_ = 0;
+    max_depth_ = 0;
+    depth_sum_ = 0;
+    running_ = true;
+    producer_ = thread(&SimulatedCamera::produce, this);
+}
+
+void SimulatedCamera::stop() {
+    running_ = false;
+    if (producer_.joinable()) {
+        producer_.join();
+    }
+}
+
+void SimulatedCamera::produce() {
+    const size_t dataset_size = replay_.size();
+    const double period_us = 1e6 / config_.fps;
+    mt19937 rng(12345);
+    uniform_real_distribution<double> jitter(-config_.jitter_us, config_.jitter_us);
+
+    auto start = chrono::steady_clock::now();
+    double previous_arrival = 0;
+    for (size_t k = 0; k < config_.frame_count && dataset_size > 0 && running_; ++k) {
+        // 抖動後的到達時間仍保持遞增
+        double arrival_us = max(previous_arrival, k * period_us + jitter(rng));
+        previous_arrival = arrival_us;
+
+        // 距離到達時間較遠時 sleep，最後一段以 yield 等待以維持精度
+        auto target = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, micro>(arrival_us));
+        while (running_) {
+            auto remaining = target - chrono::steady_clock::now();
+            if (remaining <= chrono::steady_clock::duration::zero()) {
+                break;
+            }
+            if (remaining > chrono::microseconds(200)) {
+                this_thread::sleep_for(remaining - chrono::microseconds(100));
+            } else {
+                this_thread::yield();
+            }
+        }
+
+        size_t depth = ring_.ready_count();
+        max_depth_ = max(max_depth_, depth);
+        depth_sum_ += depth;
+        produced_++;
+
+        FrameSlot* slot = ring_.try_acquire();
+        if (!slot) {
+            dropped_++;
+            continue;
+        }
+        dataset_.frame(replay_[k % dataset_size]).copyTo(slot->image);
+        slot->index = k;
+        slot->timestamp_us = static_cast<int64_t>(arrival_us);
+        ring_.publish(slot);
+    }
+    finished_.store(true, memory_order_release);
+    ring_.close();
+}
+
+bool SimulatedCamera::next(Frame& frame) {
+    // 生產者結束時會 close，已放入的影像仍會全部取出
+    FrameSlot* slot = ring_.pop_ready();
+    if (!slot) {
+        return false;
+    }
+    frame.image = slot->image;
+    frame.index = slot->index;
+    frame.timestamp_us = slot->timestamp_us;
+    frame.slot = slot;
+    return true;
+}
+
+void SimulatedCamera::release(Frame& frame) {
+    frame.image.release();
+    if (frame.slot) {
+        ring_.release(frame.slot);
+        frame.slot = nullptr;
+    }
+}
+
+CameraStats SimulatedCamera::stats() const {
+    CameraStats stats;
+    stats.produced = produced_;
+    stats.dropped = dropped_;
+    stats.max_queue_depth = max_depth_;
+    stats.mean_queue_depth = produced_ ? depth_sum_ / produced_ : 0;
+    return stats;
+}
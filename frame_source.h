@@ -0,0 +1,110 @@
+#pragma once
+
+#include "frame_stack.h"
+#include "frame_store.h"
+#include "ring_buffer.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 來源送出的一張影像
+struct Frame {
+    cv::Mat image;            // 可能指向來源內部的緩衝區，release() 之前有效
+    size_t index = 0;         // 來源中的序號
+    int64_t timestamp_us = 0; // 取像時間，相對於來源的起點
+    FrameSlot* slot = nullptr; // 來自 FrameRing 的影像槽，由 release() 歸還
+};
+
+// 影像來源：資料夾、frame stack 檔案或模擬相機。next() 只能由單一執行緒呼叫
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // 取得下一張影像，沒有更多影像時回傳 false
+    virtual bool next(Frame& frame) = 0;
+    // 影像處理完畢，可由任意執行緒呼叫；之後不可再使用 frame.image
+    virtual void release(Frame& frame) { frame.image.release(); }
+    // 影像總數，未知時為 0
+    virtual size_t size() const = 0;
+};
+
+// 依檔名順序逐張 imread 資料夾中的 .tiff (不含 background.tiff)
+class DirectorySource : public FrameSource {
+public:
+    explicit DirectorySource(const std::string& directory);
+
+    bool next(Frame& frame) override;
+    size_t size() const override { return paths_.size(); }
+    const std::vector<std::string>& paths() const { return paths_; }
+
+private:
+    std::vector<std::string> paths_;
+    size_t next_ = 0;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 以 mmap 讀取 frame stack，影像不經複製
+class FrameStackSource : public FrameSource {
+public:
+    bool open(const std::string& stack_path) { next_ = 0; return reader_.open(stack_path); }
+
+    bool next(Frame& frame) override;
+    size_t size() const override { return reader_.size(); }
+
+private:
+    FrameStackReader reader_;
+    size_t next_ = 0;
+};
+
+struct CameraConfig {
+    double fps = 5000;
+    double jitter_us = 20;       // 每張影像的到達時間在理想時間 ±jitter_us 內均勻分布
+    size_t frame_count = 10000;  // 總共送出的張數，資料集會循環重播
+    size_t ring_capacity = 64;   // 影像槽數量，全部使用中時新到的影像被丟棄，如同相機的 buffer overrun
+};
+
+struct CameraStats {
+    size_t produced = 0;         // 相機送出的張數 (包含被丟棄的)
+    size_t dropped = 0;
+    size_t max_queue_depth = 0;
+    double mean_queue_depth = 0; // 每次送出影像時的平均佇列深度
+};
+
+// 以固定 fps (加上抖動) 重播預先載入的資料集的模擬相機。
+// 生產者執行緒把影像複製到預先配置的影像槽 (如同相機 DMA) 再交給 next()；
+// 所有槽都在使用中 (尚未 release) 時丟棄該張
+class SimulatedCamera : public FrameSource {
+public:
+    SimulatedCamera(const FrameStore& dataset, const CameraConfig& config = CameraConfig());
+    ~SimulatedCamera() override;
+
+    void start();
+    void stop();
+
+    bool next(Frame& frame) override;
+    void release(Frame& frame) override;
+    size_t size() const override { return config_.frame_count; }
+
+    // stop() 之後或 next() 回傳 false 之後讀取
+    CameraStats stats() const;
+
+private:
+    void produce();
+
+    const FrameStore& dataset_;
+    std::vector<size_t> replay_;  // 資料集中可讀取的影像
+    CameraConfig config_;
+    FrameRing ring_;
+    std::thread producer_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> finished_{false};
+
+    size_t produced_ = 0;
+    size_t dropped_ = 0;
+    size_t max_depth_ = 0;
+    double depth_sum_ = 0;
+};
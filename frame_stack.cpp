@@ -0,0 +1,207 @@
+#include "frame_stack.h"
+#include "frame_runner.h"
+
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+
+static const char frame_stack_magic[8] = {'C', 'E', 'L', 'L', 'S', 'T', 'K', '1'};
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+long long convert_tiff_directory(const string& directory, const string& stack_path) {
+    vector<string> paths = list_images(directory);
+
+    ofstream out(stack_path, ios::binary | ios::trunc);
+    if (!out) {
+        return -1;
+    }
+
+    // 時間戳記區依檔案數預留，實際張數在最後回寫到 header
+    FrameStackHeader header = {};
+    memcpy(header.magic, frame_stack_magic, sizeof(header.magic));
+    header.version = FRAME_STACK_VERSION;
+    header.header_size = sizeof(FrameStackHeader);
+    header.timestamps_offset = sizeof(FrameStackHeader);
+    header.data_offset = align_up(header.timestamps_offset + paths.size() * sizeof(int64_t), FRAME_STACK_ALIGNMENT);
+
+    vector<int64_t> timestamps;
+    fs::file_time_type first_modified;
+    timestamps.reserve(paths.size());
+    out.seekp(static_cast<streamoff>(header.data_offset));
+
+    for (const string& path : paths) {
+        Mat image = imread(path, IMREAD_GRAYSCALE);
+        if (image.empty()) {
+            cerr << "Skipping unreadable image: " << path << endl;
+            continue;
+        }
+        if (timestamps.empty()) {
+            header.width = image.cols;
+            header.height = image.rows;
+            header.frame_bytes = static_cast<uint64_t>(image.cols) * image.rows;
+        } else if (static_cast<uint32_t>(image.cols) != header.width || static_cast<uint32_t>(image.rows) != header.height) {
+            cerr << "Skipping image with different size: " << path << endl;
+            continue;
+        }
+
+        for (int y = 0; y < image.rows; ++y) {
+            out.write(reinterpret_cast<const char*>(image.ptr<uchar>(y)), image.cols);
+        }
+        fs::file_time_type modified = fs::last_write_time(path);
+        if (timestamps.empty()) {
+            first_modified = modified;
+        }
+        timestamps.push_back(chrono::duration_cast<chrono::microseconds>(modified - first_modified).count());
+    }
+
+    header.count = timestamps.size();
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(timestamps.data()), timestamps.size() * sizeof(int64_t));
+    if (!out) {
+        return -1;
+    }
+    return static_cast<long long>(header.count);
+}
+
+FrameStackReader::~FrameStackReader() {
+    close();
+}
+
+bool FrameStackReader::open(const string& stack_path) {
+    close();
+
+    const void* base = nullptr;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(stack_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping) {
+        base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    file_ = file;
+    mapping_ = mapping;
+    mapped_bytes_ = base ? static_cast<size_t>(file_size.QuadPart) : 0;
+#else
+    fd_ = ::open(stack_path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) == 0 && st.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+        if (mapped != MAP_FAILED) {
+            base = mapped;
+            mapped_bytes_ = static_cast<size_t>(st.st_size);
+            madvise(mapped, mapped_bytes_, MADV_WILLNEED);
+        }
+    }
+#endif
+    if (!base) {
+        close();
+        return false;
+    }
+
+    // 驗證 header 與檔案大小，避免存取超出映射範圍。
+    // 每個區段都以除法與剩餘大小比較，損毀的 count / offset 不會因乘法或加法溢位而通過檢查
+    const FrameStackHeader* header = static_cast<const FrameStackHeader*>(base);
+    const uint64_t file_bytes = mapped_bytes_;
+    bool valid = file_bytes >= sizeof(FrameStackHeader) &&
+                 memcmp(header->magic, frame_stack_magic, sizeof(header->magic)) == 0 &&
+                 header->version == FRAME_STACK_VERSION &&
+                 header->header_size == sizeof(FrameStackHeader) &&
+                 header->width > 0 && header->width <= INT_MAX && header->height > 0 && header->height <= INT_MAX &&
+                 header->frame_bytes == static_cast<uint64_t>(header->width) * header->height &&
+                 header->timestamps_offset >= sizeof(FrameStackHeader) && header->timestamps_offset % sizeof(int64_t) == 0 &&
+                 header->timestamps_offset <= header->data_offset && header->data_offset <= file_bytes &&
+                 header->count <= (header->data_offset - header->timestamps_offset) / sizeof(int64_t) &&
+                 header->count <= (file_bytes - header->data_offset) / header->frame_bytes;
+    header_ = header;
+    if (!valid) {
+        close();
+        return false;
+    }
+    data_ = static_cast<const unsigned char*>(base) + header->data_offset;
+    return true;
+}
+
+void FrameStackReader::close() {
+    const void* base = header_;
+#ifdef _WIN32
+    if (base) {
+        UnmapViewOfFile(base);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+    file_ = nullptr;
+    mapping_ = nullptr;
+#else
+    if (base) {
+        munmap(const_cast<void*>(base), mapped_bytes_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+#endif
+    header_ = nullptr;
+    data_ = nullptr;
+    mapped_bytes_ = 0;
+}
+
+Size FrameStackReader::frame_size() const {
+    return header_ ? Size(static_cast<int>(header_->width), static_cast<int>(header_->height)) : Size();
+}
+
+int64_t FrameStackReader::timestamp(size_t index) const {
+    CV_Assert(index < size());
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(header_);
+    const int64_t* timestamps = reinterpret_cast<const int64_t*>(base + header_->timestamps_offset);
+    return timestamps[index];
+}
+
+Mat FrameStackReader::frame(size_t index) const {
+    CV_Assert(index < size());
+    uchar* pixels = const_cast<uchar*>(data_ + index * header_->frame_bytes);
+    return Mat(frame_size(), CV_8UC1, pixels);
+}
+
+Mat FrameStackReader::frames(size_t first, size_t count) const {
+    CV_Assert(is_open() && first <= size() && count <= size() - first);
+    Size size = frame_size();
+    CV_Assert(count <= static_cast<size_t>(INT_MAX / size.height));
+    uchar* pixels = const_cast<uchar*>(data_ + first * header_->frame_bytes);
+    return Mat(size.height * static_cast<int>(count), size.width, CV_8UC1, pixels);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+
+// 單一檔案的 raw frame stack，取代一個資料夾數千個 .tiff：
+//   [FrameStackHeader][count 個 int64 時間戳記(相對於第一張的微秒)][補齊到 4096][count 張緊密排列的 8 位元影像]
+// 影像資料從 4096 對齊的位置開始，可直接以 mmap 讀取而不需解碼或複製
+struct FrameStackHeader {
+    char magic[8];              // "CELLSTK1"
+    uint32_t version;
+    uint32_t header_size;       // sizeof(FrameStackHeader)
+    uint32_t width;
+    uint32_t height;
+    uint64_t count;
+    uint64_t frame_bytes;       // width * height
+    uint64_t timestamps_offset;
+    uint64_t data_offset;
+};
+
+const uint32_t FRAME_STACK_VERSION = 1;
+const uint64_t FRAME_STACK_ALIGNMENT = 4096;
+
+// 將資料夾內除 background.tiff 以外的 .tiff 依檔名順序寫成 frame stack，時間戳記取自檔案修改時間，以第一張為 0。
+// 無法讀取或大小與第一張不同的影像會被略過；回傳寫入的影像數，失敗時回傳 -1
+long long convert_tiff_directory(const std::string& directory, const std::string& stack_path);
+
+// 以唯讀 mmap 開啟 frame stack，frame() 回傳直接指向映射區的 Mat header。
+// 映射區為唯讀，不可寫入這些 Mat；index 超出 size() 時 CV_Assert 失敗
+class FrameStackReader {
+public:
+    FrameStackReader() = default;
+    ~FrameStackReader();
+    FrameStackReader(const FrameStackReader&) = delete;
+    FrameStackReader& operator=(const FrameStackReader&) = delete;
+
+    bool open(const std::string& stack_path);
+    void close();
+    bool is_open() const { return header_ != nullptr; }
+
+    size_t size() const { return header_ ? static_cast<size_t>(header_->count) : 0; }
+    cv::Size frame_size() const;
+    int64_t timestamp(size_t index) const;
+    cv::Mat frame(size_t index) const;
+    // 從 first 開始連續 count 張影像上下相接成一個 Mat (rows 為 count 乘以影像高度)，供 CellPipeline::process_batch 使用
+    cv::Mat frames(size_t first, size_t count) const;
+
+private:
+    const FrameStackHeader* header_ = nullptr;
+    const unsigned char* data_ = nullptr;
+    size_t mapped_bytes_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
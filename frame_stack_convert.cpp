@@ -0,0 +1,56 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "frame_stack.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 將 .tiff 資料夾轉成 frame stack，再以 mmap 讀回並跑一次 pipeline 確認結果
+// 用法: frame_stack_convert [資料夾] [輸出檔] [線程數]
+int main(int argc, char** argv) {
+    string directory = argc > 1 ? argv[1] : "Test_images/512x96crop";
+    string stack_path = argc > 2 ? argv[2] : directory + ".stack";
+    int num_threads = argc > 3 ? atoi(argv[3]) : 0;
+
+    auto convert_start = chrono::steady_clock::now();
+    long long count = convert_tiff_directory(directory, stack_path);
+    if (count < 0) {
+        cerr << "Error: Could not write frame stack: " << stack_path << endl;
+        return 1;
+    }
+    double convert_time = chrono::duration<double>(chrono::steady_clock::now() - convert_start).count();
+    cout << "Wrote " << count << " frames to " << stack_path << " in " << convert_time << " s" << endl;
+
+    FrameStackReader reader;
+    if (!reader.open(stack_path)) {
+        cerr << "Error: Could not map frame stack: " << stack_path << endl;
+        return 1;
+    }
+    cout << "Mapped " << reader.size() << " frames of " << reader.frame_size().width << "x" << reader.frame_size().height << endl;
+
+    CellPipeline pipeline;
+    if (!pipeline.load_background(directory + "/background.tiff")) {
+        cerr << "Error: Could not read background image in " << directory << endl;
+        return 1;
+    }
+
+    WorkspacePool workspaces;
+    vector<FrameResult> results;
+    RunStats stats = run_parallel(pipeline, reader, results, workspaces, num_threads);
+
+    size_t processed = 0;
+    for (const FrameResult& result : results) {
+        if (result.processed) {
+            processed++;
+        }
+    }
+    cout << "Processed " << processed << " of " << results.size() << " frames" << endl;
+    print_run_stats(stats);
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "frame_store.h"
+#include "frame_runner.h"
+
+#include <cstring>
+
+using namespace cv;
+using namespace std;
+
+bool FrameStore::load_directory(const string& directory) {
+    paths_ = list_images(directory);
+    decoded_.assign(paths_.size(), false);
+    frame_size_ = Size();
+    pixels_.clear();
+    if (paths_.empty()) {
+        return false;
+    }
+
+    // 第一張可讀取的影像決定大小，之後的影像直接解碼到各自的位置
+    for (size_t i = 0; i < paths_.size(); ++i) {
+        Mat image = imread(paths_[i], IMREAD_GRAYSCALE);
+        if (image.empty()) {
+            continue;
+        }
+        if (frame_size_.empty()) {
+            frame_size_ = image.size();
+            pixels_.resize(paths_.size() * static_cast<size_t>(frame_size_.area()));
+        } else if (image.size() != frame_size_) {
+            return false;
+        }
+
+        Mat dst = frame_header(i);
+        image.copyTo(dst);
+        decoded_[i] = true;
+    }
+    return !frame_size_.empty();
+}
+
+Mat FrameStore::frame(size_t index) const {
+    if (!decoded_[index]) {
+        return Mat();
+    }
+    return frame_header(index);
+}
+
+Mat FrameStore::frame_header(size_t index) const {
+    size_t frame_bytes = static_cast<size_t>(frame_size_.area());
+    uchar* data = const_cast<uchar*>(pixels_.data()) + index * frame_bytes;
+    return Mat(frame_size_, CV_8UC1, data);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// 一次解碼整個資料夾的影像並存放在同一塊連續記憶體中，之後可重複處理而不再讀檔。
+// 所有影像必須是相同大小的 8 位元灰階影像
+class FrameStore {
+public:
+    // 解碼資料夾內除 background.tiff 以外的所有 .tiff；沒有影像或大小不一致時回傳 false。
+    // 無法讀取的影像仍保留位置，frame() 回傳空的 Mat
+    bool load_directory(const std::string& directory);
+
+    size_t size() const { return paths_.size(); }
+    cv::Size frame_size() const { return frame_size_; }
+    size_t bytes() const { return pixels_.size(); }
+    const std::vector<std::string>& paths() const { return paths_; }
+
+    // 指向內部緩衝區的 Mat header，不複製資料
+    cv::Mat frame(size_t index) const;
+
+private:
+    cv::Mat frame_header(size_t index) const;
+
+    std::vector<std::string> paths_;
+    std::vector<bool> decoded_;
+    cv::Size frame_size_;
+    std::vector<unsigned char> pixels_;
+};
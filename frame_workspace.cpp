@@ -0,0 +1,32 @@
+#include "frame_workspace.h"
+
+using namespace cv;
+using namespace std;
+
+Mat workspace_region(Mat& buffer, Size size, int type) {
+    if (buffer.type() != type || buffer.cols < size.width || buffer.rows < size.height) {
+        buffer.create(size, type);
+    }
+    return buffer(Rect(Point(0, 0), size));
+}
+
+void FrameWorkspace::reserve(Size size) {
+    frame_size = size;
+
+    blurred.create(size, CV_8UC1);
+    bg_sub.create(size, CV_8UC1);
+    binary.create(size, CV_8UC1);
+
+    bits.create(size.width, size.height);
+    morphed.create(size, CV_8UC1);
+    morph_ping.create(size, CV_8UC1);
+    morph_pong.create(size, CV_8UC1);
+    edge.create(size, CV_8UC1);
+
+    // 細胞外輪廓的點數遠小於影像周長的兩倍；若超過，vector 成長後的容量會保留下來
+    size_t max_points = 2 * static_cast<size_t>(size.width + size.height);
+    tracer.reserve(size, max_points);
+    largest.points.reserve(max_points);
+    hull.reserve(3 * max_points + 2);
+    labels.create(size, CV_32S);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "binary_morphology.h"
+#include "contour_tracer.h"
+#include "fused_threshold.h"
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 每個工作執行緒各自持有的中間緩衝區。第一次處理影像時依影像大小配置，
+// 之後同大小的影像全部重複使用，穩定狀態下處理一張影像不需要任何 heap 配置
+struct FrameWorkspace {
+    cv::Size frame_size;
+
+    // blur_size 不為 5 或未使用融合核心時的 GaussianBlur / subtract 輸出
+    cv::Mat blurred;
+    cv::Mat bg_sub;
+    cv::Mat binary;
+
+    // bit-packed 形態學的輸出；OpenCV 形態學則在 ping / pong 之間交替
+    BitMask bits;
+    cv::Mat morphed;
+    cv::Mat morph_ping;
+    cv::Mat morph_pong;
+    cv::Mat edge;
+
+    // ROI 粗略偵測用的縮小影像
+    cv::Mat coarse;
+    cv::Mat coarse_diff;
+
+    BoundaryTracer tracer;
+    TracedContour largest;
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Vec4i> hierarchy;
+    std::vector<cv::Point> hull;
+
+    // 多細胞模式的 connectedComponentsWithStats 輸出
+    cv::Mat labels;
+    cv::Mat label_stats;
+    cv::Mat centroids;
+    std::vector<int> cell_labels;
+    std::vector<TracedContour> cell_contours;
+
+    // process_batch 的整個 stack：二值化、形態學輸出與每張影像的白色像素統計，
+    // 只在 stack 變大時重新配置
+    cv::Mat batch_binary;
+    cv::Mat batch_morphed;
+    BitMask batch_bits;
+    std::vector<ForegroundStats> batch_foreground;
+
+    // 依影像大小預先配置所有緩衝區
+    void reserve(cv::Size size);
+};
+
+// buffer 左上角 size 大小、型態為 type 的區域，buffer 不夠大時才重新配置。
+// 處理 ROI 時各階段輸出到整張影像大小的緩衝區的一部分，ROI 大小改變也不需要配置
+cv::Mat workspace_region(cv::Mat& buffer, cv::Size size, int type = CV_8UC1);
@@ -0,0 +1,84 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "fused_threshold.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 在 CPU 支援的每個指令集下檢查融合核心與 OpenCV 路徑的二值化結果是否逐位元相同，並比較耗時
+int main() {
+    vector<string> directories = {"Test_images/512x96crop", "Test_images/Cropped", "Test_images/In focus"};
+    const int repetitions = 100;
+
+    PipelineConfig opencv_config;
+    opencv_config.use_fused_kernel = false;
+    opencv_config.use_integer_blur = false;
+
+    // 逐一檢查 CPU 支援的每個指令集，最後恢復偵測到的指令集
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512};
+    SimdLevel detected = fused_simd_level();
+
+    int total_mismatch_images = 0;
+    for (SimdLevel level : levels) {
+        if (!simd_level_supported(level)) {
+            continue;
+        }
+        set_simd_level_for_testing(level);
+        cout << "SIMD level: " << simd_level_name(level) << endl;
+
+        for (const string& directory : directories) {
+            CellPipeline pipeline(opencv_config);
+            if (!pipeline.load_background(directory + "/background.tiff")) {
+                cerr << "Error: Could not read background image in " << directory << endl;
+                continue;
+            }
+
+            double opencv_time = 0, fused_time = 0;
+            int mismatch_images = 0, images = 0;
+            for (const string& path : list_images(directory)) {
+                Mat image = imread(path, IMREAD_GRAYSCALE);
+                if (image.empty()) {
+                    continue;
+                }
+
+                Mat expected, actual;
+                ForegroundStats foreground;
+                auto start = chrono::high_resolution_clock::now();
+                for (int i = 0; i < repetitions; ++i) {
+                    pipeline.segment(image, expected);
+                }
+                auto middle = chrono::high_resolution_clock::now();
+                for (int i = 0; i < repetitions; ++i) {
+                    fused_blur_subtract_threshold(image, pipeline.blurred_background(), opencv_config.threshold_value, actual, &foreground);
+                }
+                auto end = chrono::high_resolution_clock::now();
+                opencv_time += chrono::duration<double, micro>(middle - start).count();
+                fused_time += chrono::duration<double, micro>(end - middle).count();
+
+                // 白色像素數與外接矩形也必須與 countNonZero / boundingRect 相同
+                int diff = countNonZero(expected != actual);
+                int white = countNonZero(expected);
+                Rect bounds = white ? boundingRect(expected) : Rect();
+                if (diff > 0 || foreground.count != white || foreground.bounds != bounds) {
+                    cout << "Mismatch: " << path << " (" << diff << " pixels, white pixels " << foreground.count << " vs " << white << ")" << endl;
+                    mismatch_images++;
+                }
+                images++;
+            }
+
+            int runs = max(1, images * repetitions);
+            cout << directory << ": " << images << " images, " << mismatch_images << " mismatched" << endl;
+            cout << "  OpenCV blur/subtract/threshold: " << opencv_time / runs << " microseconds" << endl;
+            cout << "  Fused kernel:                   " << fused_time / runs << " microseconds" << endl;
+            total_mismatch_images += mismatch_images;
+        }
+    }
+    set_simd_level_for_testing(detected);
+
+    return total_mismatch_images == 0 ? 0 : 1;
+}
@@ -0,0 +1,507 @@
+#include "fused_threshold.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FUSED_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FUSED_TARGET(isa)
+#else
+#define FUSED_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+using namespace cv;
+using namespace std;
+
+// 垂直 1-4-6-4-1：v[x + 2] = r0 + 4 * (r1 + r3) + 6 * r2 + r4，最大 255 * 16
+struct RowForeground {
+    int count;
+    int first; // 沒有白色像素時為 -1
+    int last;
+};
+
+// bits 的 bit i 對應 x + i
+static inline void add_row_bits(RowForeground& row, uint32_t bits, int x) {
+    if (!bits) {
+        return;
+    }
+#if defined(_MSC_VER)
+    unsigned long low, high;
+    _BitScanForward(&low, bits);
+    _BitScanReverse(&high, bits);
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    row.count += static_cast<int>((((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#else
+    int low = __builtin_ctz(bits);
+    int high = 31 - __builtin_clz(bits);
+    row.count += __builtin_popcount(bits);
+#endif
+    if (row.first < 0) {
+        row.first = x + static_cast<int>(low);
+    }
+    row.last = x + static_cast<int>(high);
+}
+
+typedef void (*VerticalRowFn)(const uchar* const* rows, ushort* v, int width);
+// 水平 1-4-6-4-1 + 捨入 + 背景相減 + 閾值，v[0] 對應 x = -2。
+// 同時累計該列的白色像素數與最左、最右的白色像素
+typedef void (*HorizontalRowFn)(const ushort* v, const uchar* bg, uchar* dst, int width, int threshold, RowForeground& row);
+// 只做水平 1-4-6-4-1 + 捨入，供 gaussian_blur_5x5 使用
+typedef void (*BlurRowFn)(const ushort* v, uchar* dst, int width);
+
+static void vertical_row_scalar(const uchar* const* rows, ushort* v, int x, int width) {
+    for (; x < width; ++x) {
+        v[x + 2] = static_cast<ushort>(rows[0][x] + rows[4][x] + 4 * (rows[1][x] + rows[3][x]) + 6 * rows[2][x]);
+    }
+}
+
+static void horizontal_row_scalar(const ushort* v, const uchar* bg, uchar* dst, int x, int width, int threshold, RowForeground& row) {
+    for (; x < width; ++x) {
+        const ushort* p = v + x;
+        int sum = p[0] + p[4] + 4 * (p[1] + p[3]) + 6 * p[2];
+        int blurred = (sum + 128) >> 8;
+        bool white = bg[x] - blurred > threshold;
+        dst[x] = white ? 255 : 0;
+        if (white) {
+            row.count++;
+            if (row.first < 0) {
+                row.first = x;
+            }
+            row.last = x;
+        }
+    }
+}
+
+static void blur_row_scalar(const ushort* v, uchar* dst, int x, int width) {
+    for (; x < width; ++x) {
+        const ushort* p = v + x;
+        int sum = p[0] + p[4] + 4 * (p[1] + p[3]) + 6 * p[2];
+        dst[x] = static_cast<uchar>((sum + 128) >> 8);
+    }
+}
+
+static void vertical_scalar(const uchar* const* rows, ushort* v, int width) {
+    vertical_row_scalar(rows, v, 0, width);
+}
+
+static void horizontal_scalar(const ushort* v, const uchar* bg, uchar* dst, int width, int threshold, RowForeground& row) {
+    horizontal_row_scalar(v, bg, dst, 0, width, threshold, row);
+}
+
+static void blur_scalar(const ushort* v, uchar* dst, int width) {
+    blur_row_scalar(v, dst, 0, width);
+}
+
+#ifdef FUSED_X86
+
+FUSED_TARGET("sse4.1")
+static void vertical_sse41(const uchar* const* rows, ushort* v, int width) {
+    const __m128i six = _mm_set1_epi16(6);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[0] + x)));
+        __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[1] + x)));
+        __m128i c = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[2] + x)));
+        __m128i d = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[3] + x)));
+        __m128i e = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[4] + x)));
+        __m128i s = _mm_add_epi16(_mm_add_epi16(a, e), _mm_slli_epi16(_mm_add_epi16(b, d), 2));
+        s = _mm_add_epi16(s, _mm_mullo_epi16(c, six));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x + 2), s);
+    }
+    vertical_row_scalar(rows, v, x, width);
+}
+
+FUSED_TARGET("sse4.1")
+static void horizontal_sse41(const ushort* v, const uchar* bg, uchar* dst, int width, int threshold, RowForeground& row) {
+    const __m128i six = _mm_set1_epi16(6);
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i thresh = _mm_set1_epi16(static_cast<short>(threshold));
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const ushort* p = v + x;
+        __m128i m2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2));
+        __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 3));
+        __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+        __m128i s = _mm_add_epi16(_mm_add_epi16(m2, p2), _mm_slli_epi16(_mm_add_epi16(m1, p1), 2));
+        s = _mm_add_epi16(s, _mm_mullo_epi16(c, six));
+        __m128i blurred = _mm_srli_epi16(_mm_add_epi16(s, round), 8);
+        __m128i bgv = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bg + x)));
+        __m128i mask = _mm_cmpgt_epi16(bgv, _mm_add_epi16(blurred, thresh));
+        __m128i packed = _mm_packs_epi16(mask, mask);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), packed);
+        add_row_bits(row, static_cast<uint32_t>(_mm_movemask_epi8(packed)) & 0xFFu, x);
+    }
+    horizontal_row_scalar(v, bg, dst, x, width, threshold, row);
+}
+
+FUSED_TARGET("sse4.1")
+static void blur_sse41(const ushort* v, uchar* dst, int width) {
+    const __m128i six = _mm_set1_epi16(6);
+    const __m128i round = _mm_set1_epi16(128);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const ushort* p = v + x;
+        __m128i m2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2));
+        __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 3));
+        __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+        __m128i s = _mm_add_epi16(_mm_add_epi16(m2, p2), _mm_slli_epi16(_mm_add_epi16(m1, p1), 2));
+        s = _mm_add_epi16(s, _mm_mullo_epi16(c, six));
+        __m128i blurred = _mm_srli_epi16(_mm_add_epi16(s, round), 8);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(blurred, blurred));
+    }
+    blur_row_scalar(v, dst, x, width);
+}
+
+FUSED_TARGET("avx2")
+static void vertical_avx2(const uchar* const* rows, ushort* v, int width) {
+    const __m256i six = _mm256_set1_epi16(6);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[0] + x)));
+        __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[1] + x)));
+        __m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[2] + x)));
+        __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[3] + x)));
+        __m256i e = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[4] + x)));
+        __m256i s = _mm256_add_epi16(_mm256_add_epi16(a, e), _mm256_slli_epi16(_mm256_add_epi16(b, d), 2));
+        s = _mm256_add_epi16(s, _mm256_mullo_epi16(c, six));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + x + 2), s);
+    }
+    vertical_row_scalar(rows, v, x, width);
+}
+
+FUSED_TARGET("avx2")
+static void horizontal_avx2(const ushort* v, const uchar* bg, uchar* dst, int width, int threshold, RowForeground& row) {
+    const __m256i six = _mm256_set1_epi16(6);
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i thresh = _mm256_set1_epi16(static_cast<short>(threshold));
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const ushort* p = v + x;
+        __m256i m2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i m1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2));
+        __m256i p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 3));
+        __m256i p2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 4));
+        __m256i s = _mm256_add_epi16(_mm256_add_epi16(m2, p2), _mm256_slli_epi16(_mm256_add_epi16(m1, p1), 2));
+        s = _mm256_add_epi16(s, _mm256_mullo_epi16(c, six));
+        __m256i blurred = _mm256_srli_epi16(_mm256_add_epi16(s, round), 8);
+        __m256i bgv = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bg + x)));
+        __m256i mask = _mm256_cmpgt_epi16(bgv, _mm256_add_epi16(blurred, thresh));
+        __m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(mask), _mm256_extracti128_si256(mask, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), packed);
+        add_row_bits(row, static_cast<uint32_t>(_mm_movemask_epi8(packed)), x);
+    }
+    horizontal_row_scalar(v, bg, dst, x, width, threshold, row);
+}
+
+FUSED_TARGET("avx2")
+static void blur_avx2(const ushort* v, uchar* dst, int width) {
+    const __m256i six = _mm256_set1_epi16(6);
+    const __m256i round = _mm256_set1_epi16(128);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const ushort* p = v + x;
+        __m256i m2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i m1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2));
+        __m256i p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 3));
+        __m256i p2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 4));
+        __m256i s = _mm256_add_epi16(_mm256_add_epi16(m2, p2), _mm256_slli_epi16(_mm256_add_epi16(m1, p1), 2));
+        s = _mm256_add_epi16(s, _mm256_mullo_epi16(c, six));
+        __m256i blurred = _mm256_srli_epi16(_mm256_add_epi16(s, round), 8);
+        __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(blurred), _mm256_extracti128_si256(blurred, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), packed);
+    }
+    blur_row_scalar(v, dst, x, width);
+}
+
+FUSED_TARGET("avx512f,avx512bw")
+static void vertical_avx512(const uchar* const* rows, ushort* v, int width) {
+    const __m512i six = _mm512_set1_epi16(6);
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m512i a = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[0] + x)));
+        __m512i b = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[1] + x)));
+        __m512i c = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[2] + x)));
+        __m512i d = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[3] + x)));
+        __m512i e = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[4] + x)));
+        __m512i s = _mm512_add_epi16(_mm512_add_epi16(a, e), _mm512_slli_epi16(_mm512_add_epi16(b, d), 2));
+        s = _mm512_add_epi16(s, _mm512_mullo_epi16(c, six));
+        _mm512_storeu_si512(v + x + 2, s);
+    }
+    vertical_row_scalar(rows, v, x, width);
+}
+
+FUSED_TARGET("avx512f,avx512bw")
+static void horizontal_avx512(const ushort* v, const uchar* bg, uchar* dst, int width, int threshold, RowForeground& row) {
+    const __m512i six = _mm512_set1_epi16(6);
+    const __m512i round = _mm512_set1_epi16(128);
+    const __m512i thresh = _mm512_set1_epi16(static_cast<short>(threshold));
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const ushort* p = v + x;
+        __m512i m2 = _mm512_loadu_si512(p);
+        __m512i m1 = _mm512_loadu_si512(p + 1);
+        __m512i c = _mm512_loadu_si512(p + 2);
+        __m512i p1 = _mm512_loadu_si512(p + 3);
+        __m512i p2 = _mm512_loadu_si512(p + 4);
+        __m512i s = _mm512_add_epi16(_mm512_add_epi16(m2, p2), _mm512_slli_epi16(_mm512_add_epi16(m1, p1), 2));
+        s = _mm512_add_epi16(s, _mm512_mullo_epi16(c, six));
+        __m512i blurred = _mm512_srli_epi16(_mm512_add_epi16(s, round), 8);
+        __m512i bgv = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bg + x)));
+        __mmask32 mask = _mm512_cmpgt_epi16_mask(bgv, _mm512_add_epi16(blurred, thresh));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm512_cvtepi16_epi8(_mm512_maskz_set1_epi16(mask, 0xFF)));
+        add_row_bits(row, static_cast<uint32_t>(mask), x);
+    }
+    horizontal_row_scalar(v, bg, dst, x, width, threshold, row);
+}
+
+FUSED_TARGET("avx512f,avx512bw")
+static void blur_avx512(const ushort* v, uchar* dst, int width) {
+    const __m512i six = _mm512_set1_epi16(6);
+    const __m512i round = _mm512_set1_epi16(128);
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const ushort* p = v + x;
+        __m512i m2 = _mm512_loadu_si512(p);
+        __m512i m1 = _mm512_loadu_si512(p + 1);
+        __m512i c = _mm512_loadu_si512(p + 2);
+        __m512i p1 = _mm512_loadu_si512(p + 3);
+        __m512i p2 = _mm512_loadu_si512(p + 4);
+        __m512i s = _mm512_add_epi16(_mm512_add_epi16(m2, p2), _mm512_slli_epi16(_mm512_add_epi16(m1, p1), 2));
+        s = _mm512_add_epi16(s, _mm512_mullo_epi16(c, six));
+        __m512i blurred = _mm512_srli_epi16(_mm512_add_epi16(s, round), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm512_cvtepi16_epi8(blurred));
+    }
+    blur_row_scalar(v, dst, x, width);
+}
+
+#endif // FUSED_X86
+
+static SimdLevel detected_simd_level() {
+#ifdef FUSED_X86
+    static const SimdLevel level = []() {
+        if (checkHardwareSupport(CV_CPU_AVX_512BW)) {
+            return SimdLevel::AVX512;
+        }
+        if (checkHardwareSupport(CV_CPU_AVX2)) {
+            return SimdLevel::AVX2;
+        }
+        if (checkHardwareSupport(CV_CPU_SSE4_1)) {
+            return SimdLevel::SSE41;
+        }
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// set_simd_level_for_testing 設定的指令集，-1 表示使用偵測到的指令集
+static atomic<int> forced_simd_level(-1);
+
+SimdLevel fused_simd_level() {
+    int forced = forced_simd_level.load(memory_order_relaxed);
+    return forced >= 0 ? static_cast<SimdLevel>(forced) : detected_simd_level();
+}
+
+bool simd_level_supported(SimdLevel level) {
+    return static_cast<int>(level) <= static_cast<int>(detected_simd_level());
+}
+
+void set_simd_level_for_testing(SimdLevel level) {
+    CV_Assert(simd_level_supported(level));
+    forced_simd_level.store(static_cast<int>(level), memory_order_relaxed);
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512: return "AVX-512";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::SSE41: return "SSE4.1";
+    default: return "scalar";
+    }
+}
+
+// 與 cv::borderInterpolate(p, len, BORDER_REFLECT_101) 相同
+static int reflect_101(int p, int len) {
+    if (len == 1) {
+        return 0;
+    }
+    while (p < 0 || p >= len) {
+        p = p < 0 ? -p : 2 * len - p - 2;
+    }
+    return p;
+}
+
+// 單張影像的閾值超出 8U 範圍時，與 threshold() 一致：閾值小於 0 全白，大於等於 255 全黑
+static void constant_frame(uchar* dst, size_t dst_step, int width, int height, int threshold, ForegroundStats* foreground) {
+    for (int y = 0; y < height; ++y) {
+        memset(dst + y * dst_step, threshold < 0 ? 255 : 0, width);
+    }
+    if (foreground) {
+        foreground->count = threshold < 0 ? width * height : 0;
+        foreground->bounds = threshold < 0 ? Rect(0, 0, width, height) : Rect();
+    }
+}
+
+// 單張影像的兩次掃描，v 為 width + 4 個元素的垂直加總緩衝區
+static void fused_frame(VerticalRowFn vertical, HorizontalRowFn horizontal, ushort* v,
+                        const uchar* src, size_t src_step, const uchar* blurred_bg, size_t bg_step,
+                        uchar* dst, size_t dst_step, int width, int height, int threshold,
+                        ForegroundStats* foreground) {
+    int left1 = reflect_101(-1, width), left2 = reflect_101(-2, width);
+    int right1 = reflect_101(width, width), right2 = reflect_101(width + 1, width);
+
+    int count = 0;
+    int min_x = width, max_x = -1, min_y = -1, max_y = -1;
+
+    for (int y = 0; y < height; ++y) {
+        const uchar* rows[5];
+        for (int k = 0; k < 5; ++k) {
+            rows[k] = src + reflect_101(y + k - 2, height) * src_step;
+        }
+        vertical(rows, v, width);
+        v[1] = v[left1 + 2];
+        v[0] = v[left2 + 2];
+        v[width + 2] = v[right1 + 2];
+        v[width + 3] = v[right2 + 2];
+
+        RowForeground row = { 0, -1, -1 };
+        horizontal(v, blurred_bg + y * bg_step, dst + y * dst_step, width, threshold, row);
+        if (row.count) {
+            count += row.count;
+            min_x = min(min_x, row.first);
+            max_x = max(max_x, row.last);
+            if (min_y < 0) {
+                min_y = y;
+            }
+            max_y = y;
+        }
+    }
+
+    if (foreground) {
+        foreground->count = count;
+        foreground->bounds = count ? Rect(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1) : Rect();
+    }
+}
+
+void fused_blur_subtract_threshold(const uchar* src, size_t src_step,
+                                   const uchar* blurred_bg, size_t bg_step,
+                                   uchar* dst, size_t dst_step,
+                                   int width, int height, int threshold,
+                                   ForegroundStats* foreground) {
+    fused_blur_subtract_threshold_batch(src, src_step, height * src_step, blurred_bg, bg_step, dst, dst_step,
+                                        width, height, 1, threshold, foreground);
+}
+
+void fused_blur_subtract_threshold_batch(const uchar* src, size_t src_step, size_t src_frame_step,
+                                         const uchar* blurred_bg, size_t bg_step,
+                                         uchar* dst, size_t dst_step,
+                                         int width, int height, int frames, int threshold,
+                                         ForegroundStats* foreground) {
+    const size_t dst_frame_step = height * dst_step;
+    if (threshold < 0 || threshold >= 255) {
+        for (int i = 0; i < frames; ++i) {
+            constant_frame(dst + i * dst_frame_step, dst_step, width, height, threshold, foreground ? foreground + i : nullptr);
+        }
+        return;
+    }
+
+    VerticalRowFn vertical = vertical_scalar;
+    HorizontalRowFn horizontal = horizontal_scalar;
+#ifdef FUSED_X86
+    switch (fused_simd_level()) {
+    case SimdLevel::AVX512:
+        vertical = vertical_avx512;
+        horizontal = horizontal_avx512;
+        break;
+    case SimdLevel::AVX2:
+        vertical = vertical_avx2;
+        horizontal = horizontal_avx2;
+        break;
+    case SimdLevel::SSE41:
+        vertical = vertical_sse41;
+        horizontal = horizontal_sse41;
+        break;
+    default:
+        break;
+    }
+#endif
+
+    // 垂直加總列，左右各留 2 格做 REFLECT_101 邊界；所有影像共用
+    AutoBuffer<ushort, 1024> buffer(width + 4);
+    for (int i = 0; i < frames; ++i) {
+        fused_frame(vertical, horizontal, buffer.data(), src + i * src_frame_step, src_step, blurred_bg, bg_step,
+                    dst + i * dst_frame_step, dst_step, width, height, threshold, foreground ? foreground + i : nullptr);
+    }
+}
+
+void fused_blur_subtract_threshold(const Mat& image, const Mat& blurred_bg, double threshold, Mat& binary,
+                                   ForegroundStats* foreground) {
+    CV_Assert(image.type() == CV_8UC1 && blurred_bg.type() == CV_8UC1 && image.size() == blurred_bg.size());
+    binary.create(image.size(), CV_8UC1);
+    fused_blur_subtract_threshold(image.ptr<uchar>(), image.step, blurred_bg.ptr<uchar>(), blurred_bg.step,
+                                  binary.ptr<uchar>(), binary.step, image.cols, image.rows, cvFloor(threshold), foreground);
+}
+
+void gaussian_blur_5x5(const uchar* src, size_t src_step, uchar* dst, size_t dst_step, int width, int height) {
+    VerticalRowFn vertical = vertical_scalar;
+    BlurRowFn blur = blur_scalar;
+#ifdef FUSED_X86
+    switch (fused_simd_level()) {
+    case SimdLevel::AVX512:
+        vertical = vertical_avx512;
+        blur = blur_avx512;
+        break;
+    case SimdLevel::AVX2:
+        vertical = vertical_avx2;
+        blur = blur_avx2;
+        break;
+    case SimdLevel::SSE41:
+        vertical = vertical_sse41;
+        blur = blur_sse41;
+        break;
+    default:
+        break;
+    }
+#endif
+
+    AutoBuffer<ushort, 1024> buffer(width + 4);
+    ushort* v = buffer.data();
+    int left1 = reflect_101(-1, width), left2 = reflect_101(-2, width);
+    int right1 = reflect_101(width, width), right2 = reflect_101(width + 1, width);
+    for (int y = 0; y < height; ++y) {
+        const uchar* rows[5];
+        for (int k = 0; k < 5; ++k) {
+            rows[k] = src + reflect_101(y + k - 2, height) * src_step;
+        }
+        vertical(rows, v, width);
+        v[1] = v[left1 + 2];
+        v[0] = v[left2 + 2];
+        v[width + 2] = v[right1 + 2];
+        v[width + 3] = v[right2 + 2];
+        blur(v, dst + y * dst_step, width);
+    }
+}
+
+void gaussian_blur_5x5(const Mat& image, Mat& blurred) {
+    CV_Assert(image.type() == CV_8UC1);
+    // 逐列寫出時仍會讀取上兩列，不能原地處理
+    Mat src = image.data == blurred.data ? image.clone() : image;
+    blurred.create(src.size(), CV_8UC1);
+    gaussian_blur_5x5(src.ptr<uchar>(), src.step, blurred.ptr<uchar>(), blurred.step, src.cols, src.rows);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+
+// 融合 GaussianBlur(5x5, sigma=0) + subtract(blurred_bg, blurred) + threshold(THRESH_BINARY) 的單次掃描核心。
+// 使用 1-4-6-4-1 整數權重與 OpenCV 8U 的定點捨入 (S + 128) >> 8，邊界為 BORDER_REFLECT_101，
+// 因此輸出與 OpenCV 路徑逐位元相同，但不產生 blurred / bg_sub 兩張中間影像。
+
+enum class SimdLevel {
+    Scalar,
+    SSE41,
+    AVX2,
+    AVX512
+};
+
+// 二值化結果的白色像素數與外接矩形，與 countNonZero / boundingRect 的結果相同
+struct ForegroundStats {
+    int count = 0;
+    cv::Rect bounds; // 沒有白色像素時為空
+};
+
+// 融合核心與 gaussian_blur_5x5 使用的指令集：預設為執行期偵測到的 CPU 支援的最高指令集
+SimdLevel fused_simd_level();
+const char* simd_level_name(SimdLevel level);
+// CPU 是否支援 level (Scalar 永遠支援)
+bool simd_level_supported(SimdLevel level);
+// 只供檢查工具使用：強制之後的呼叫使用 level，以便逐一驗證各指令集的核心。level 必須是 CPU 支援的
+void set_simd_level_for_testing(SimdLevel level);
+
+// 原始指標介面，step 為每列的位元組數
+void fused_blur_subtract_threshold(const unsigned char* src, size_t src_step,
+                                   const unsigned char* blurred_bg, size_t bg_step,
+                                   unsigned char* dst, size_t dst_step,
+                                   int width, int height, int threshold,
+                                   ForegroundStats* foreground = nullptr);
+
+// frames 張 width x height 的影像一次處理，全部使用同一張 blurred_bg，指令集只選擇一次。
+// 第 i 張影像從 src + i * src_frame_step 開始 (緊密排列時為 height * src_step，也可以是裁切後的 view)，
+// 輸出緊密排列，第 i 張從 dst + i * height * dst_step 開始。
+// 每張影像的上下邊界各自以 REFLECT_101 補值，結果與逐張呼叫相同；foreground 非 nullptr 時為 frames 個元素的陣列
+void fused_blur_subtract_threshold_batch(const unsigned char* src, size_t src_step, size_t src_frame_step,
+                                         const unsigned char* blurred_bg, size_t bg_step,
+                                         unsigned char* dst, size_t dst_step,
+                                         int width, int height, int frames, int threshold,
+                                         ForegroundStats* foreground = nullptr);
+
+// image 與 blurred_bg 必須是相同大小的 CV_8UC1。
+// foreground 非 nullptr 時順便輸出白色像素數與外接矩形，不需要再掃描一次 binary
+void fused_blur_subtract_threshold(const cv::Mat& image, const cv::Mat& blurred_bg, double threshold, cv::Mat& binary,
+                                   ForegroundStats* foreground = nullptr);
+
+// 只做 GaussianBlur(5x5, sigma=0)：與融合核心相同的 1-4-6-4-1 整數權重、16 位元累加與 (S + 128) >> 8 捨入，
+// 邊界為 BORDER_REFLECT_101 且不讀取範圍外的像素 (相當於 BORDER_ISOLATED)，輸出與 OpenCV 8U 逐位元相同
+void gaussian_blur_5x5(const unsigned char* src, size_t src_step, unsigned char* dst, size_t dst_step, int width, int height);
+
+// image 必須是 CV_8UC1，blurred 可以是 workspace_region 取得的 view
+void gaussian_blur_5x5(const cv::Mat& image, cv::Mat& blurred);
@@ -0,0 +1,77 @@
+#include "cell_pipeline.h"
+#include "convex_hull.h"
+#include "frame_runner.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+// 比較 convexHull + contourArea + arcLength 與線性凸包的面積、周長與耗時
+int main() {
+    vector<string> directories = {"Test_images/512x96crop", "Test_images/Cropped", "Test_images/In focus"};
+    const int repetitions = 100;
+    int total_mismatches = 0;
+
+    for (const string& directory : directories) {
+        CellPipeline pipeline;
+        if (!pipeline.load_background(directory + "/background.tiff")) {
+            cerr << "Error: Could not read background image in " << directory << endl;
+            continue;
+        }
+
+        vector<Point> hull, buffer;
+        double opencv_time = 0, linear_time = 0;
+        int contours_checked = 0, mismatches = 0;
+        for (const string& path : list_images(directory)) {
+            Mat image = imread(path, IMREAD_GRAYSCALE);
+            if (image.empty()) {
+                continue;
+            }
+            Mat binary, mask;
+            pipeline.segment(image, binary);
+            pipeline.morphology(binary, mask);
+
+            vector<vector<Point>> contours;
+            findContours(mask, contours, RETR_LIST, CHAIN_APPROX_NONE);
+            for (const vector<Point>& contour : contours) {
+                double area = 0, perimeter = 0;
+                HullMetrics metrics;
+
+                auto start = chrono::high_resolution_clock::now();
+                for (int i = 0; i < repetitions; ++i) {
+                    convexHull(contour, hull);
+                    area = contourArea(hull);
+                    perimeter = arcLength(hull, true);
+                }
+                auto middle = chrono::high_resolution_clock::now();
+                for (int i = 0; i < repetitions; ++i) {
+                    metrics = convex_hull_metrics(contour, &buffer);
+                }
+                auto end = chrono::high_resolution_clock::now();
+                opencv_time += chrono::duration<double, micro>(middle - start).count();
+                linear_time += chrono::duration<double, micro>(end - middle).count();
+
+                // 面積為整數運算必須完全相同；周長的每段以 float 計算，加總順序不同只容許捨入誤差
+                if (area != metrics.area || abs(perimeter - metrics.perimeter) > 1e-5 * max(1.0, perimeter)) {
+                    cout << "Mismatch: " << path << " (" << contour.size() << " points) area " << area << " vs " << metrics.area
+                         << ", perimeter " << perimeter << " vs " << metrics.perimeter << endl;
+                    mismatches++;
+                }
+                contours_checked++;
+            }
+        }
+
+        int runs = max(1, contours_checked * repetitions);
+        cout << directory << ": " << contours_checked << " contours, " << mismatches << " mismatched" << endl;
+        cout << "  convexHull + contourArea + arcLength: " << opencv_time / runs << " microseconds" << endl;
+        cout << "  Linear hull metrics:                  " << linear_time / runs << " microseconds" << endl;
+        total_mismatches += mismatches;
+    }
+
+    return total_mismatches == 0 ? 0 : 1;
+}
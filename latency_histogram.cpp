@@ -0,0 +1,175 @@
+#include "latency_histogram.h"
+#include "cell_pipeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+using namespace std;
+
+static int highest_bit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+int LatencyHistogram::bucket_index(uint64_t nanoseconds) {
+    if (nanoseconds < 2 * SUB_BUCKETS) {
+        return static_cast<int>(nanoseconds);
+    }
+    // 保留最高的 SUB_BUCKET_BITS + 1 個位元：v >> shift 落在 [SUB_BUCKETS, 2 * SUB_BUCKETS)
+    int shift = highest_bit(nanoseconds) - SUB_BUCKET_BITS;
+    if (shift > MAX_SHIFT) {
+        return BUCKETS - 1;
+    }
+    return shift * SUB_BUCKETS + static_cast<int>(nanoseconds >> shift);
+}
+
+uint64_t LatencyHistogram::bucket_lower(int index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t mantissa = static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS);
+    return mantissa << shift;
+}
+
+uint64_t LatencyHistogram::bucket_upper(int index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    return bucket_lower(index) + (1ull << shift) - 1;
+}
+
+LatencyHistogram::LatencyHistogram() : counts_(BUCKETS, 0) {
+}
+
+void LatencyHistogram::record(double microseconds) {
+    uint64_t nanoseconds = microseconds > 0 ? static_cast<uint64_t>(llround(microseconds * 1000.0)) : 0;
+    counts_[bucket_index(nanoseconds)]++;
+    count_++;
+    min_ = std::min(min_, nanoseconds);
+    max_ = std::max(max_, nanoseconds);
+    sum_ += microseconds;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+void LatencyHistogram::reset() {
+    fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+    sum_ = 0;
+}
+
+double LatencyHistogram::min() const {
+    return count_ ? min_ / 1000.0 : 0;
+}
+
+double LatencyHistogram::max() const {
+    return max_ / 1000.0;
+}
+
+double LatencyHistogram::mean() const {
+    return count_ ? sum_ / count_ : 0;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(ceil(std::clamp(p, 0.0, 100.0) / 100.0 * count_));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(bucket_upper(i), max_) / 1000.0;
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::dump_buckets(ostream& out, const string& prefix) const {
+    for (int i = 0; i < BUCKETS; ++i) {
+        if (counts_[i]) {
+            out << prefix << ',' << bucket_lower(i) / 1000.0 << ',' << bucket_upper(i) / 1000.0 << ',' << counts_[i] << '\n';
+        }
+    }
+}
+
+const char* latency_stage_name(LatencyStage stage) {
+    switch (stage) {
+    case LatencyStage::Preprocess: return "preprocess";
+    case LatencyStage::Contours: return "contours";
+    case LatencyStage::Metrics: return "metrics";
+    case LatencyStage::Frame: return "frame";
+    default: return "unknown";
+    }
+}
+
+void StageLatencies::record(const FrameResult& result) {
+    if (result.preprocess_duration > 0) {
+        (*this)[LatencyStage::Preprocess].record(result.preprocess_duration);
+    }
+    if (result.findcontour_duration > 0) {
+        (*this)[LatencyStage::Contours].record(result.findcontour_duration);
+    }
+    if (result.processed) {
+        (*this)[LatencyStage::Metrics].record(result.metrics_duration);
+        (*this)[LatencyStage::Frame].record(result.total_duration);
+    }
+}
+
+void StageLatencies::merge(const StageLatencies& other) {
+    for (size_t i = 0; i < stages.size(); ++i) {
+        stages[i].merge(other.stages[i]);
+    }
+}
+
+void StageLatencies::reset() {
+    for (LatencyHistogram& histogram : stages) {
+        histogram.reset();
+    }
+}
+
+void StageLatencies::print(ostream& out) const {
+    out << "Latency (microseconds):" << endl;
+    out << left << setw(12) << "stage" << right << setw(10) << "count" << setw(10) << "mean"
+        << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "p99.9" << setw(10) << "max" << endl;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const LatencyHistogram& h = stages[i];
+        out << left << setw(12) << latency_stage_name(static_cast<LatencyStage>(i)) << right
+            << setw(10) << h.count() << fixed << setprecision(2)
+            << setw(10) << h.mean() << setw(10) << h.percentile(50) << setw(10) << h.percentile(90)
+            << setw(10) << h.percentile(99) << setw(10) << h.percentile(99.9) << setw(10) << h.max()
+            << defaultfloat << endl;
+    }
+}
+
+bool StageLatencies::dump_csv(const string& path) const {
+    ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "stage,lower_us,upper_us,count\n";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        stages[i].dump_buckets(out, latency_stage_name(static_cast<LatencyStage>(i)));
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// HDR 風格的延遲直方圖：數值以奈秒為單位，小於 256 時每個值一格，
+// 之後每個 2 的冪次區間再線性切成 128 格，相對誤差小於 1/128。
+// 格子在建構時一次配置 (約 36 KB)，之後記錄不再配置記憶體；各執行緒各自記錄後以 merge 合併
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    static const int SUB_BUCKET_BITS = 7;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_SHIFT = 34;  // 可記錄到約 2^42 奈秒 (約 73 分鐘)，更大的值歸入最後一格
+    static const int BUCKETS = SUB_BUCKETS * (MAX_SHIFT + 2);
+
+    void record(double microseconds);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    double min() const;   // 微秒
+    double max() const;
+    double mean() const;
+    // p 介於 0 到 100，回傳該百分位所在格的上界 (不超過 max)
+    double percentile(double p) const;
+
+    // 輸出非零的格子：lower_us,upper_us,count
+    void dump_buckets(std::ostream& out, const std::string& prefix) const;
+
+private:
+    static int bucket_index(uint64_t nanoseconds);
+    static uint64_t bucket_lower(int index);
+    static uint64_t bucket_upper(int index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+    double sum_ = 0;
+};
+
+enum class LatencyStage {
+    Preprocess, // blur / subtract / threshold / 白色像素過濾 / 形態學
+    Contours,   // findContours 或 tracer
+    Metrics,    // 凸包與圓度
+    Frame,      // 單張影像從前處理到指標的總時間
+    Count
+};
+
+const char* latency_stage_name(LatencyStage stage);
+
+struct FrameResult;
+
+// 各階段各一個直方圖，只記錄實際執行過的階段
+struct StageLatencies {
+    std::array<LatencyHistogram, static_cast<int>(LatencyStage::Count)> stages;
+
+    LatencyHistogram& operator[](LatencyStage stage) { return stages[static_cast<int>(stage)]; }
+    const LatencyHistogram& operator[](LatencyStage stage) const { return stages[static_cast<int>(stage)]; }
+
+    void record(const FrameResult& result);
+    void merge(const StageLatencies& other);
+    void reset();
+
+    // 每個階段一列：count / mean / p50 / p90 / p99 / p99.9 / max
+    void print(std::ostream& out) const;
+    // 機器可讀的 CSV：stage,lower_us,upper_us,count
+    bool dump_csv(const std::string& path) const;
+};
@@ -0,0 +1,71 @@
+#include "binary_morphology.h"
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 檢查 bit-packed 形態學與 OpenCV dilate/erode 串接的結果是否相同，並比較耗時
+int main() {
+    vector<string> directories = {"Test_images/512x96crop", "Test_images/Cropped", "Test_images/In focus"};
+    const int repetitions = 100;
+
+    PipelineConfig opencv_config;
+    opencv_config.use_bit_morphology = false;
+    PipelineConfig bit_config;
+
+    int total_mismatch_images = 0;
+    for (const string& directory : directories) {
+        CellPipeline opencv_pipeline(opencv_config);
+        CellPipeline bit_pipeline(bit_config);
+        string background_path = directory + "/background.tiff";
+        if (!opencv_pipeline.load_background(background_path) || !bit_pipeline.load_background(background_path)) {
+            cerr << "Error: Could not read background image: " << background_path << endl;
+            continue;
+        }
+
+        double opencv_time = 0, bit_time = 0;
+        int mismatch_images = 0, images = 0;
+        for (const string& path : list_images(directory)) {
+            Mat image = imread(path, IMREAD_GRAYSCALE);
+            if (image.empty()) {
+                continue;
+            }
+            Mat binary;
+            opencv_pipeline.segment(image, binary);
+
+            Mat expected, actual;
+            auto start = chrono::high_resolution_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                opencv_pipeline.morphology(binary, expected);
+            }
+            auto middle = chrono::high_resolution_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                bit_pipeline.morphology(binary, actual);
+            }
+            auto end = chrono::high_resolution_clock::now();
+            opencv_time += chrono::duration<double, micro>(middle - start).count();
+            bit_time += chrono::duration<double, micro>(end - middle).count();
+
+            int diff = countNonZero(expected != actual);
+            if (diff > 0) {
+                cout << "Mismatch: " << path << " (" << diff << " pixels)" << endl;
+                mismatch_images++;
+            }
+            images++;
+        }
+
+        int runs = max(1, images * repetitions);
+        cout << directory << ": " << images << " images, " << mismatch_images << " mismatched" << endl;
+        cout << "  OpenCV dilate/erode: " << opencv_time / runs << " microseconds" << endl;
+        cout << "  Bit-packed engine:   " << bit_time / runs << " microseconds" << endl;
+        total_mismatch_images += mismatch_images;
+    }
+
+    return total_mismatch_images == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 比較 parallel_for 與分階段 pipeline 兩種模式的吞吐量
+int main(int argc, char** argv) {
+    string directory = "Test_images/Slight under focus";
+    int num_threads = argc > 1 ? atoi(argv[1]) : 0;
+    int max_tokens = argc > 2 ? atoi(argv[2]) : 0;
+    const int repetitions = 100;
+
+    string background_path = directory + "/background.tiff";
+    PipelineConfig config;
+    config.crop = SLIGHT_UNDER_FOCUS_CROP;
+    CellPipeline pipeline(config);
+    if (!pipeline.load_background(background_path)) {
+        cerr << "Error: Could not read background image: " << background_path << endl;
+        return -1;
+    }
+
+    vector<string> image_paths = list_images(directory);
+    vector<FrameResult> results;
+
+    RunStats parallel_total, pipelined_total;
+    for (int i = 0; i < repetitions; ++i) {
+        RunStats stats = run_parallel(pipeline, image_paths, results, num_threads);
+        parallel_total.threads = stats.threads;
+        parallel_total.frames += stats.frames;
+        parallel_total.wall_time += stats.wall_time;
+        parallel_total.latency.merge(stats.latency);
+
+        stats = run_pipelined(pipeline, image_paths, results, max_tokens, num_threads);
+        pipelined_total.threads = stats.threads;
+        pipelined_total.frames += stats.frames;
+        pipelined_total.wall_time += stats.wall_time;
+        pipelined_total.latency.merge(stats.latency);
+    }
+    parallel_total.frames_per_second = parallel_total.frames / parallel_total.wall_time;
+    pipelined_total.frames_per_second = pipelined_total.frames / pipelined_total.wall_time;
+
+    cout << "parallel_for:      ";
+    print_run_stats(parallel_total);
+    parallel_total.latency.print(cout);
+    cout << "parallel_pipeline: ";
+    print_run_stats(pipelined_total);
+    pipelined_total.latency.print(cout);
+
+    return 0;
+}
@@ -1,3 +1,5 @@
+#include "cell_pipeline.h"
+#include "fused_threshold.h"
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <string>
@@ -13,22 +15,18 @@ struct ImageInfo {
     int white_pixel_count;
 };
 
-void process_single_image(const fs::path& image_path, const Mat& blurred_bg, ImageInfo& max_info, ImageInfo& min_info) {
+void process_single_image(const fs::path& image_path, const CellPipeline& pipeline, ImageInfo& max_info, ImageInfo& min_info) {
     Mat image = imread(image_path.string(), IMREAD_GRAYSCALE);
     if (image.empty()) {
         cout << "Unable to open or find image: " << image_path << endl;
         return;
     }
 
-    Mat blurred;
-    GaussianBlur(image, blurred, Size(5, 5), 0);
-    Mat bg_sub;
-    subtract(blurred_bg, blurred, bg_sub);
+    // 白色像素數與外接矩形在二值化時一併算出
     Mat binary;
-    threshold(bg_sub, binary, 10, 255, THRESH_BINARY);
-
-    // Count white pixels
-    int white_pixel_count = countNonZero(binary);
+    ForegroundStats foreground;
+    pipeline.segment(image, binary, &foreground);
+    int white_pixel_count = foreground.count;
 
     // Update max and min info if necessary
     if (white_pixel_count > max_info.white_pixel_count) {
@@ -43,6 +41,8 @@ void process_single_image(const fs::path& image_path, const Mat& blurred_bg, Ima
     // Output results for current image
     cout << "Image: " << image_path.filename().string() << endl;
     cout << "White pixel count: " << white_pixel_count << endl;
+    cout << "Bounding box: " << foreground.bounds.x << ", " << foreground.bounds.y << ", "
+         << foreground.bounds.width << " x " << foreground.bounds.height << endl;
     cout << endl;
 }
 
@@ -55,22 +55,19 @@ int main() {
         return -1;
     }
 
-    Mat background = imread(background_path.string(), IMREAD_GRAYSCALE);
-    if (background.empty()) {
+    CellPipeline pipeline;
+    if (!pipeline.load_background(background_path.string())) {
         cerr << "Unable to open or find background image: " << background_path << endl;
         return -1;
     }
 
-    Mat blurred_bg;
-    GaussianBlur(background, blurred_bg, Size(5, 5), 0);
-
     ImageInfo max_info = {"", 0};
     ImageInfo min_info = {"", numeric_limits<int>::max()};
 
     bool processed_any_file = false;
     for (const auto& entry : fs::directory_iterator(directory)) {
         if (entry.is_regular_file() && entry.path().extension() == ".tiff" && entry.path().filename() != "background.tiff") {
-            process_single_image(entry.path(), blurred_bg, max_info, min_info);
+            process_single_image(entry.path(), pipeline, max_info, min_info);
             processed_any_file = true;
         }
     }
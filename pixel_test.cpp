@@ -1,177 +1,52 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <filesystem>
 #include <cmath>
-#include <tbb/task_arena.h>
-#include <tbb/task_group.h>
-#include <tbb/concurrent_queue.h>
-#include <atomic>
-#include <mutex>
-
-#define _USE_MATH_DEFINES
-#include <math.h>
 
 namespace fs = std::filesystem;
 using namespace cv;
 using namespace std;
 
-struct ContourMetrics {
-    double area_original = 0;
-    double area_hull = 0;
-    double area_ratio = 0;
-    double circularity_original = 0;
-    double circularity_hull = 0;
-    double circularity_ratio = 0;
-};
-
-ContourMetrics calculate_contour_metrics(const vector<vector<Point>>& contours) {
-    if (contours.empty()) {
-        return ContourMetrics();
-    }
-
-    auto cnt = *max_element(contours.begin(), contours.end(),
-                            [](const auto& c1, const auto& c2) { return contourArea(c1) < contourArea(c2); });
-
-    double area_original = contourArea(cnt);
-    double perimeter_original = arcLength(cnt, true);
-
-    if (area_original <= 1e-6 || perimeter_original <= 1e-6) {
-        return ContourMetrics();
-    }
-
-    double circularity_original = 4 * M_PI * area_original / (perimeter_original * perimeter_original);
-
-    vector<Point> hull;
-    convexHull(cnt, hull);
-
-    double area_hull = contourArea(hull);
-    double perimeter_hull = arcLength(hull, true);
-
-    if (area_hull <= 1e-6 || perimeter_hull <= 1e-6) {
-        return ContourMetrics();
-    }
-
-    double circularity_hull = 4 * M_PI * area_hull / (perimeter_hull * perimeter_hull);
-
-    ContourMetrics results;
-    results.area_original = area_original;
-    results.area_hull = area_hull;
-    results.area_ratio = area_hull / area_original;
-    results.circularity_original = circularity_original;
-    results.circularity_hull = circularity_hull;
-    results.circularity_ratio = circularity_hull / circularity_original;
-
-    return results;
-}
-
-void process_single_image(const string& image_path, const Mat& blurred_bg, vector<vector<Point>>& contours, ContourMetrics& metrics, double& duration) {
-    Mat image = imread(image_path, IMREAD_GRAYSCALE);
-    auto start_time = chrono::high_resolution_clock::now();
-
-    Mat blurred;
-    GaussianBlur(image, blurred, Size(5, 5), 0);
-    Mat bg_sub;
-    subtract(blurred_bg, blurred, bg_sub);
-    Mat binary;
-    threshold(bg_sub, binary, 10, 255, THRESH_BINARY);
-
-    // 計算白色像素面積
-    int white_pixel_count = countNonZero(binary);
-    
-    // 如果白色像素面積不在250~650範圍內，直接返回
-    if (white_pixel_count < 250 || white_pixel_count > 650) {
-        duration = 0;
-        return;
-    }
-
-    Mat kernel = getStructuringElement(MORPH_CROSS, Size(3, 3));
-    Mat dilate1, erode1, dilate2;
-    dilate(binary, dilate1, kernel, Point(-1, -1), 2);
-    erode(dilate1, erode1, kernel, Point(-1, -1), 3);
-    dilate(erode1, dilate2, kernel, Point(-1, -1), 1);
-
-    vector<Vec4i> hierarchy;
-    
-    findContours(dilate2, contours, hierarchy, RETR_LIST, CHAIN_APPROX_NONE);
-
-    auto end_time = chrono::high_resolution_clock::now();
-    duration = chrono::duration<double, micro>(end_time - start_time).count();
-
-    if (!contours.empty()) {
-        metrics = calculate_contour_metrics(contours);
-    }
-}
-
-void run_experiment(string directory, vector<tuple<string, double, double, double>>& results, vector<string>& skipped_images, pair<string, double>& max_time_image) {
+void run_experiment(string directory, const PipelineConfig& config, int num_threads, vector<tuple<string, double, double, double>>& results, vector<string>& skipped_images, pair<string, double>& max_time_image, RunStats& stats) {
     string background_path = directory + "/background.tiff";
-    Mat background = imread(background_path, IMREAD_GRAYSCALE);
-    if (background.empty()) {
+    CellPipeline pipeline(config);
+    if (!pipeline.load_background(background_path)) {
         cerr << "Error: Could not read background image: " << background_path << endl;
         return;
     }
-    Mat blurred_bg;
-    GaussianBlur(background, blurred_bg, Size(5, 5), 0);
-
-    atomic<double> total_time(0);
-    atomic<int> number(0);
-    atomic<double> max_process_time(0);
-    mutex mtx;
 
-    tbb::task_arena arena(thread::hardware_concurrency());
-    tbb::task_group group;
-    tbb::concurrent_queue<fs::path> image_queue;
+    vector<string> image_paths = list_images(directory);
+    vector<FrameResult> frames;
+    stats = run_parallel(pipeline, image_paths, frames, num_threads);
 
-    atomic<bool> processing_complete(false);
-
-    arena.execute([&]() {
-        group.run([&]() {
-            while (!processing_complete || !image_queue.empty()) {
-                fs::path path;
-                if (image_queue.try_pop(path)) {
-                    vector<vector<Point>> contours;
-                    ContourMetrics metrics;
-                    double process_time;
-                    process_single_image(path.string(), blurred_bg, contours, metrics, process_time);
-
-                    if (process_time > 0) {  // 只處理有效的圖片
-                        lock_guard<mutex> lock(mtx);
-                        total_time = total_time + process_time;
-                        if (process_time > max_process_time) {
-                            max_process_time = process_time;
-                            max_time_image = { path.string(), process_time };
-                        }
-                        number++;
-                        results.push_back(make_tuple(path.string(), metrics.circularity_ratio, metrics.area_ratio, process_time));
-                    } else {
-                        lock_guard<mutex> lock(mtx);
-                        skipped_images.push_back(path.string());
-                    }
-                } else {
-                    this_thread::yield();
-                }
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const FrameResult& frame = frames[i];
+        if (frame.processed) {
+            if (frame.duration > max_time_image.second) {
+                max_time_image = { image_paths[i], frame.duration };
             }
-        });
-    });
-
-    for (const auto& entry : fs::directory_iterator(directory)) {
-        if (entry.path().extension() == ".tiff" && entry.path().filename() != "background.tiff") {
-            image_queue.push(entry.path());
+            results.push_back(make_tuple(image_paths[i], frame.metrics.circularity_ratio, frame.metrics.area_ratio, frame.duration));
+        } else {
+            skipped_images.push_back(image_paths[i]);
         }
     }
-
-    processing_complete = true;
-    group.wait();
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // 可指定線程數量，預設使用全部硬體線程
+    int num_threads = argc > 1 ? atoi(argv[1]) : 0;
     string directory = "Test_images/512x96crop";
+    PipelineConfig config;
     vector<tuple<string, double, double, double>> results;
     vector<string> skipped_images;
     pair<string, double> max_time_image;
+    RunStats stats;
 
-    run_experiment(directory, results, skipped_images, max_time_image);
+    run_experiment(directory, config, num_threads, results, skipped_images, max_time_image, stats);
 
     // 輸出結果
     cout << "Circularity ratio and area ratio for each processed image:" << endl;
@@ -190,6 +65,7 @@ int main() {
     double average_time = results.empty() ? 0 : total_time / results.size();
 
     cout << "\nAverage processing time: " << average_time << " microseconds" << endl;
+    print_run_stats(stats);
     
     fs::path max_time_path(max_time_image.first);
     cout << "Max processing time: " << max_time_image.second << " microseconds for image: " 
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// 固定容量的無鎖環形緩衝區與預先配置的影像槽，讓影像從取像到處理之間的交接不需配置記憶體
+
+const size_t CACHE_LINE_SIZE = 64;
+
+inline void cpu_relax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// 等待時先短暫自旋，再讓出時間片，最後以短暫 sleep 阻塞，避免長時間佔用 CPU
+class Backoff {
+public:
+    void wait() {
+        if (step_ < 6) {
+            for (int i = 0; i < (1 << step_); ++i) {
+                cpu_relax();
+            }
+        } else if (step_ < 12) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        if (step_ < 12) {
+            step_++;
+        }
+    }
+    void reset() { step_ = 0; }
+
+private:
+    int step_ = 0;
+};
+
+inline size_t ring_capacity_for(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// 多生產者、多消費者 (Vyukov bounded queue)：每格以序號判斷可寫或可讀，
+// 成功時只需一次 CAS 搶佔位置
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity)
+        : capacity_(ring_capacity_for(capacity)), mask_(capacity_ - 1), cells_(new Cell[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    size_t size() const {
+        return enqueue_pos_.value.load(std::memory_order_acquire) - dequeue_pos_.value.load(std::memory_order_acquire);
+    }
+
+    bool try_push(T value) {
+        size_t pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        size_t pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->sequence.store(pos + capacity_, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        Backoff backoff;
+        while (!try_pop(value)) {
+            if (closed_.value.load(std::memory_order_acquire)) {
+                return try_pop(value);
+            }
+            backoff.wait();
+        }
+        return true;
+    }
+
+    void close() { closed_.value.store(true, std::memory_order_release); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    template <typename U>
+    struct alignas(CACHE_LINE_SIZE) Padded {
+        U value{};
+    };
+
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    Padded<std::atomic<size_t>> enqueue_pos_;
+    Padded<std::atomic<size_t>> dequeue_pos_;
+    Padded<std::atomic<bool>> closed_;
+};
+
+// 預先配置像素緩衝區的影像槽
+struct FrameSlot {
+    cv::Mat image;
+    size_t index = 0;
+    int64_t timestamp_us = 0;
+};
+
+// 固定數量的影像槽在 free 與 ready 兩個佇列之間流動，佇列中傳遞的只是槽的編號：
+// 生產者 try_acquire() 取空槽、寫入像素後 publish()；消費者 pop_ready() 取得後處理，release() 歸還。
+// 兩個佇列都是 MPMC，任何一端都可以有多個執行緒
+class FrameRing {
+public:
+    FrameRing(size_t slot_count, cv::Size frame_size)
+        : slots_(slot_count), frame_size_(frame_size), free_(slot_count), ready_(slot_count) {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            slots_[i].image.create(frame_size, CV_8UC1);
+            free_.try_push(static_cast<uint32_t>(i));
+        }
+    }
+
+    size_t slot_count() const { return slots_.size(); }
+    cv::Size frame_size() const { return frame_size_; }
+    size_t ready_count() const { return ready_.size(); }
+
+    // 生產者：取得空槽，全部使用中時回傳 nullptr (由呼叫端決定丟棄或等待)
+    FrameSlot* try_acquire() {
+        uint32_t id;
+        return free_.try_pop(id) ? &slots_[id] : nullptr;
+    }
+
+    void publish(FrameSlot* slot) { ready_.try_push(slot_id(slot)); }
+
+    // 消費者：阻塞直到有影像；close() 後且已取空時回傳 nullptr
+    FrameSlot* pop_ready() {
+        uint32_t id;
+        return ready_.pop(id) ? &slots_[id] : nullptr;
+    }
+
+    void release(FrameSlot* slot) { free_.try_push(slot_id(slot)); }
+
+    void close() { ready_.close(); }
+
+private:
+    uint32_t slot_id(const FrameSlot* slot) const { return static_cast<uint32_t>(slot - slots_.data()); }
+
+    std::vector<FrameSlot> slots_;
+    cv::Size frame_size_;
+    MpmcRing<uint32_t> free_;
+    MpmcRing<uint32_t> ready_;
+};
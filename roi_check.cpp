@@ -0,0 +1,74 @@
+#include "cell_pipeline.h"
+#include "frame_runner.h"
+#include "frame_store.h"
+#include "frame_workspace.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// 比較整張影像與 ROI 兩階段處理的結果與每張耗時
+int main() {
+    vector<string> directories = {"Test_images/512x96crop", "Test_images/Cropped", "Test_images/In focus"};
+    const int repetitions = 100;
+
+    int total_mismatches = 0;
+    for (const string& directory : directories) {
+        PipelineConfig roi_config;
+        roi_config.use_roi = true;
+        CellPipeline full_pipeline, roi_pipeline(roi_config);
+        FrameStore store;
+        if (!full_pipeline.load_background(directory + "/background.tiff") ||
+            !roi_pipeline.load_background(directory + "/background.tiff") || !store.load_directory(directory)) {
+            cerr << "Error: Could not preload images in " << directory << endl;
+            continue;
+        }
+
+        FrameWorkspace full_workspace, roi_workspace;
+        FrameResult full_result, roi_result;
+        double full_time = 0, roi_time = 0, roi_area = 0;
+        int images = 0, mismatches = 0, roi_frames = 0;
+        for (size_t i = 0; i < store.size(); ++i) {
+            Mat image = store.frame(i);
+            if (image.empty()) {
+                continue;
+            }
+
+            auto start = chrono::high_resolution_clock::now();
+            for (int k = 0; k < repetitions; ++k) {
+                full_pipeline.process(image, full_workspace, full_result);
+            }
+            auto middle = chrono::high_resolution_clock::now();
+            for (int k = 0; k < repetitions; ++k) {
+                roi_pipeline.process(image, roi_workspace, roi_result);
+            }
+            auto end = chrono::high_resolution_clock::now();
+            full_time += chrono::duration<double, micro>(middle - start).count();
+            roi_time += chrono::duration<double, micro>(end - middle).count();
+
+            if (full_result.processed != roi_result.processed || full_result.contours != roi_result.contours) {
+                cout << "Mismatch: " << store.paths()[i] << " processed " << full_result.processed << " vs " << roi_result.processed
+                     << ", white pixels " << full_result.white_pixel_count << " vs " << roi_result.white_pixel_count << endl;
+                mismatches++;
+            }
+            if (!roi_result.roi.empty()) {
+                roi_area += static_cast<double>(roi_result.roi.area()) / image.total();
+                roi_frames++;
+            }
+            images++;
+        }
+
+        int runs = max(1, images * repetitions);
+        cout << directory << ": " << images << " images, " << mismatches << " mismatched, mean ROI "
+             << 100.0 * roi_area / max(1, roi_frames) << " % of the frame" << endl;
+        cout << "  Full frame: " << full_time / runs << " microseconds" << endl;
+        cout << "  ROI:        " << roi_time / runs << " microseconds" << endl;
+        total_mismatches += mismatches;
+    }
+
+    return total_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#include "stage_timer.h"
+
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define STAGE_TIMER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STAGE_TIMER_TSC 1
+#endif
+
+using namespace std;
+
+uint64_t read_cycles() {
+#if defined(STAGE_TIMER_TSC)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+double cycles_per_microsecond() {
+    static const double rate = []() {
+        // 忙等約 20 ms，比較兩個時鐘的增量
+        auto clock_start = chrono::steady_clock::now();
+        uint64_t cycles_start = read_cycles();
+        chrono::steady_clock::time_point clock_end;
+        do {
+            clock_end = chrono::steady_clock::now();
+        } while (clock_end - clock_start < chrono::milliseconds(20));
+        uint64_t cycles_end = read_cycles();
+        double us = chrono::duration<double, micro>(clock_end - clock_start).count();
+        return (cycles_end - cycles_start) / us;
+    }();
+    return rate;
+}
+
+const char* timed_stage_name(TimedStage stage) {
+    switch (stage) {
+    case TimedStage::Roi: return "roi";
+    case TimedStage::Blur: return "blur";
+    case TimedStage::Subtract: return "subtract";
+    case TimedStage::Threshold: return "threshold";
+    case TimedStage::FusedSegment: return "fused segment";
+    case TimedStage::WhiteCount: return "white count";
+    case TimedStage::MorphPack: return "morph pack";
+    case TimedStage::Dilate: return "dilate";
+    case TimedStage::Erode: return "erode";
+    case TimedStage::MorphUnpack: return "morph unpack";
+    case TimedStage::Canny: return "canny";
+    case TimedStage::Contours: return "contours";
+    case TimedStage::Hull: return "hull";
+    case TimedStage::Metrics: return "metrics";
+    default: return "unknown";
+    }
+}
+
+struct StageTable {
+    uint64_t cycles[static_cast<int>(TimedStage::Count)] = {};
+    uint64_t calls[static_cast<int>(TimedStage::Count)] = {};
+};
+
+// 所有執行緒的表格；執行緒結束後表格仍保留，合併時不會遺失
+static mutex tables_mutex;
+static deque<StageTable> tables;
+
+#ifdef CELL_STAGE_TIMING
+void add_stage_cycles(TimedStage stage, uint64_t cycles) {
+    thread_local StageTable* table = []() {
+        lock_guard<mutex> lock(tables_mutex);
+        tables.emplace_back();
+        return &tables.back();
+    }();
+    table->cycles[static_cast<int>(stage)] += cycles;
+    table->calls[static_cast<int>(stage)]++;
+}
+#endif
+
+void reset_stage_timers() {
+    lock_guard<mutex> lock(tables_mutex);
+    for (StageTable& table : tables) {
+        table = StageTable();
+    }
+}
+
+void print_stage_timers(ostream& out) {
+#ifndef CELL_STAGE_TIMING
+    out << "Stage timing disabled (configure with -DCELL_STAGE_TIMING=ON)" << endl;
+#else
+    StageTable total;
+    {
+        lock_guard<mutex> lock(tables_mutex);
+        for (const StageTable& table : tables) {
+            for (int i = 0; i < static_cast<int>(TimedStage::Count); ++i) {
+                total.cycles[i] += table.cycles[i];
+                total.calls[i] += table.calls[i];
+            }
+        }
+    }
+
+    double rate = cycles_per_microsecond();
+    out << "Stage timing (" << fixed << setprecision(1) << rate << " cycles/us):" << endl;
+    out << left << setw(16) << "stage" << right << setw(12) << "calls" << setw(14) << "avg cycles"
+        << setw(12) << "avg us" << setw(14) << "total ms" << endl;
+    for (int i = 0; i < static_cast<int>(TimedStage::Count); ++i) {
+        if (!total.calls[i]) {
+            continue;
+        }
+        double avg_cycles = static_cast<double>(total.cycles[i]) / total.calls[i];
+        out << left << setw(16) << timed_stage_name(static_cast<TimedStage>(i)) << right
+            << setw(12) << total.calls[i] << setprecision(0) << setw(14) << avg_cycles
+            << setprecision(3) << setw(12) << avg_cycles / rate
+            << setprecision(3) << setw(14) << total.cycles[i] / rate / 1000.0 << endl;
+    }
+    out << defaultfloat;
+#endif
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+
+// 以 TSC 計時各階段的輕量計時器。定義 CELL_STAGE_TIMING (CMake 選項 CELL_STAGE_TIMING=ON) 時才會計時，
+// 否則 STAGE_TIMER 展開為空，不留下任何程式碼。
+// 每個執行緒累加到自己的表格，print_stage_timers 時才合併，處理過程中不需同步
+
+enum class TimedStage {
+    Roi,          // ROI 粗略偵測
+    Blur,
+    Subtract,
+    Threshold,
+    FusedSegment, // 融合核心 (blur + subtract + threshold)
+    WhiteCount,
+    MorphPack,
+    Dilate,
+    Erode,
+    MorphUnpack,
+    Canny,
+    Contours,
+    Hull,
+    Metrics,      // 包含 Hull
+    Count
+};
+
+const char* timed_stage_name(TimedStage stage);
+
+// x86 讀 TSC，AArch64 讀 cntvct_el0，其他平台退回 steady_clock 的奈秒
+uint64_t read_cycles();
+// 第一次呼叫時以 steady_clock 校正一次
+double cycles_per_microsecond();
+
+void reset_stage_timers();
+// 每個階段一列：呼叫次數、平均 cycles、平均微秒、總毫秒
+void print_stage_timers(std::ostream& out);
+
+#ifdef CELL_STAGE_TIMING
+
+void add_stage_cycles(TimedStage stage, uint64_t cycles);
+
+class StageScope {
+public:
+    explicit StageScope(TimedStage stage) : stage_(stage), start_(read_cycles()) {}
+    ~StageScope() { add_stage_cycles(stage_, read_cycles() - start_); }
+    StageScope(const StageScope&) = delete;
+    StageScope& operator=(const StageScope&) = delete;
+
+private:
+    TimedStage stage_;
+    uint64_t start_;
+};
+
+#define STAGE_TIMER_CONCAT_(a, b) a##b
+#define STAGE_TIMER_NAME_(line) STAGE_TIMER_CONCAT_(stage_scope_, line)
+// 計時到目前的 scope 結束
+#define STAGE_TIMER(stage) StageScope STAGE_TIMER_NAME_(__LINE__)(TimedStage::stage)
+
+#else
+
+#define STAGE_TIMER(stage) ((void)0)
+
+#endif
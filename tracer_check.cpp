@@ -0,0 +1,81 @@
+#include "cell_pipeline.h"
+#include "contour_tracer.h"
+#include "frame_runner.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+// 比較 tracer 與 findContours + 最大輪廓的面積、周長與耗時
+int main() {
+    vector<string> directories = {"Test_images/512x96crop", "Test_images/Cropped", "Test_images/In focus"};
+    const int repetitions = 100;
+
+    int total_mismatches = 0;
+    for (const string& directory : directories) {
+        CellPipeline pipeline;
+        if (!pipeline.load_background(directory + "/background.tiff")) {
+            cerr << "Error: Could not read background image in " << directory << endl;
+            continue;
+        }
+
+        BoundaryTracer tracer;
+        double findcontour_time = 0, tracer_time = 0;
+        int images = 0, mismatches = 0, multi_blob = 0;
+        for (const string& path : list_images(directory)) {
+            Mat image = imread(path, IMREAD_GRAYSCALE);
+            if (image.empty()) {
+                continue;
+            }
+            Mat binary, mask;
+            pipeline.segment(image, binary);
+            pipeline.morphology(binary, mask);
+
+            vector<vector<Point>> contours;
+            vector<Vec4i> hierarchy;
+            TracedContour traced;
+            int blobs = 0;
+
+            auto start = chrono::high_resolution_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                findContours(mask, contours, hierarchy, RETR_LIST, CHAIN_APPROX_NONE);
+            }
+            auto middle = chrono::high_resolution_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                blobs = tracer.trace_largest(mask, traced);
+            }
+            auto end = chrono::high_resolution_clock::now();
+            findcontour_time += chrono::duration<double, micro>(middle - start).count();
+            tracer_time += chrono::duration<double, micro>(end - middle).count();
+
+            double area = 0, perimeter = 0;
+            int largest = largest_contour(contours, &area);
+            if (largest >= 0) {
+                perimeter = arcLength(contours[largest], true);
+            }
+            if (area != traced.area || abs(perimeter - traced.perimeter) > 1e-6) {
+                cout << "Mismatch: " << path << " area " << area << " vs " << traced.area
+                     << ", perimeter " << perimeter << " vs " << traced.perimeter << endl;
+                mismatches++;
+            }
+            if (blobs > 1) {
+                multi_blob++;
+            }
+            images++;
+        }
+
+        int runs = max(1, images * repetitions);
+        cout << directory << ": " << images << " images, " << multi_blob << " with multiple blobs, "
+             << mismatches << " mismatched" << endl;
+        cout << "  findContours + largest: " << findcontour_time / runs << " microseconds" << endl;
+        cout << "  Boundary tracer:        " << tracer_time / runs << " microseconds" << endl;
+        total_mismatches += mismatches;
+    }
+
+    return total_mismatches == 0 ? 0 : 1;
+}